@@ -0,0 +1,148 @@
+#ifndef CORONIMO_FRAME_STATS_H_
+#define CORONIMO_FRAME_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace adva::coronimo {
+
+/**
+ * @file frame_stats.h
+ * @brief Coroutine frame allocation telemetry
+ *
+ * @details Frame sizes are only known to the compiler, so they are observed where the
+ * frames are allocated: the promise types' operator new reports every allocation, and
+ * the promise picks up the size of its own frame right after. Coroutine functions are
+ * told apart by the resume function pointer stored in the first word of every frame,
+ * the layout GCC, Clang and MSVC share; map it back to a function with nm or addr2line.
+ *
+ * Frames whose allocation the compiler elided report a size of 0 and are not counted.
+ */
+
+/**
+ * @brief Allocation totals over all coroutine frames
+ */
+struct frame_totals {
+    size_t current_bytes = 0;     ///< Bytes held by live frames
+    size_t peak_bytes = 0;        ///< High-water mark of current_bytes
+    uint32_t live_frames = 0;
+    uint32_t peak_frames = 0;     ///< High-water mark of live_frames
+    uint32_t allocations = 0;     ///< Frames allocated so far
+    uint32_t largest_frame = 0;   ///< Largest single frame seen
+};
+
+/**
+ * @brief Allocation statistics of one coroutine function
+ */
+struct frame_function_stats {
+    void const* function;    ///< Resume function of the coroutine, identifies it
+    uint32_t frame_size;     ///< Size of its frame
+    uint32_t live;           ///< Frames currently alive
+    uint32_t peak_live;      ///< High-water mark of live
+    uint32_t allocations;    ///< Frames created so far
+};
+
+/**
+ * @brief Frame memory attributed to one task: its own frame plus nested async_func frames
+ */
+struct task_frame_usage {
+    uint32_t frame_size = 0;         ///< The task's own frame
+    uint32_t stack_bytes = 0;        ///< async_func frames currently on its callstack
+    uint32_t peak_stack_bytes = 0;   ///< High-water mark of stack_bytes
+};
+
+struct no_task_frame_usage {};
+
+/**
+ * @brief Fixed-capacity registry behind the frame statistics
+ *
+ * @tparam N Number of distinct coroutine functions tracked individually; further
+ *           functions still count towards the totals and are reported as untracked
+ */
+template <size_t N>
+class frame_registry {
+public:
+    static constexpr uint16_t untracked_index = UINT16_MAX;
+
+    void on_allocate(size_t n) noexcept {
+        pending_size_ = static_cast<uint32_t>(n);
+        totals_.current_bytes += n;
+        totals_.allocations++;
+        totals_.live_frames++;
+        if (totals_.current_bytes > totals_.peak_bytes) totals_.peak_bytes = totals_.current_bytes;
+        if (totals_.live_frames > totals_.peak_frames) totals_.peak_frames = totals_.live_frames;
+        if (n > totals_.largest_frame) totals_.largest_frame = static_cast<uint32_t>(n);
+    }
+    void on_deallocate(size_t n) noexcept {
+        totals_.current_bytes -= n;
+        totals_.live_frames--;
+    }
+    /// A frame's memory was kept for a new frame instead of being freed and allocated again
+    void on_reuse(size_t n) noexcept {
+        pending_size_ = static_cast<uint32_t>(n);
+    }
+
+    /// Size of the frame allocated last, handed to the promise being constructed in it
+    uint32_t take_pending_size() noexcept {
+        uint32_t n = pending_size_;
+        pending_size_ = 0;
+        return n;
+    }
+
+    /**
+     * @brief Attributes a new frame to its coroutine function
+     * @return Index to pass to release() when the frame is destroyed
+     */
+    uint16_t acquire(void const* function, uint32_t frame_size) noexcept {
+        if (frame_size == 0) return untracked_index;
+
+        size_t i = 0;
+        for ( ; i < count_; i++) {
+            if (functions_[i].function == function) break;
+        }
+        if (i == count_) {
+            if (count_ == N) {
+                untracked_++;
+                return untracked_index;
+            }
+            functions_[count_++] = frame_function_stats{ function, frame_size, 0, 0, 0 };
+        }
+
+        auto& f = functions_[i];
+        f.allocations++;
+        if (++f.live > f.peak_live) f.peak_live = f.live;
+        return static_cast<uint16_t>(i);
+    }
+    void release(uint16_t index) noexcept {
+        if (index != untracked_index) functions_[index].live--;
+    }
+
+    frame_totals const& totals() const noexcept { return totals_; }
+
+    /// Frames of functions that did not fit into the table
+    uint32_t untracked() const noexcept { return untracked_; }
+
+    template <typename F>
+    void for_each_function(F&& f) const {
+        for (size_t i = 0; i < count_; i++) f(functions_[i]);
+    }
+
+private:
+    frame_totals totals_{};
+    frame_function_stats functions_[N]{};
+    size_t count_ = 0;
+    uint32_t untracked_ = 0;
+    uint32_t pending_size_ = 0;
+};
+
+/**
+ * @brief Per-frame bookkeeping stored in a promise when frame statistics are enabled
+ */
+struct frame_tag {
+    uint32_t size = 0;
+    uint16_t index = UINT16_MAX;
+};
+
+}
+
+#endif // CORONIMO_FRAME_STATS_H_
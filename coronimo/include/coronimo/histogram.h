@@ -0,0 +1,131 @@
+#ifndef CORONIMO_HISTOGRAM_H_
+#define CORONIMO_HISTOGRAM_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace adva::coronimo {
+
+/**
+ * @file histogram.h
+ * @brief Compact log-linear (HDR-style) histogram of 32-bit values
+ *
+ * @details Values below 2^(SubBits+1) are counted exactly. Above that, every power of two
+ * range is split into 2^SubBits linear sub-buckets, so the relative error of any reported
+ * value is below 2^-SubBits while the whole 32-bit range fits in (33 - SubBits) << SubBits
+ * counters. With the default SubBits = 3 this is 240 counters and 12.5 % precision.
+ *
+ * Recording is a bit scan, a shift and an increment, cheap enough for the wakeup path.
+ *
+ * Example usage:
+ * @code
+ * log_linear_histogram<> h;
+ * h.record(latency);
+ * auto p99 = h.value_at_percentile(99.0);
+ * auto p999 = h.value_at_percentile(99.9);
+ * h.reset();
+ * @endcode
+ */
+template <unsigned SubBits = 3, typename Count = uint32_t>
+class log_linear_histogram {
+    static_assert(SubBits < 16, "too many sub-buckets");
+
+public:
+    static constexpr size_t bucket_count = size_t(33 - SubBits) << SubBits;
+
+    void record(uint32_t value) noexcept {
+        counts_[index_of(value)]++;
+        total_++;
+        if (value > max_) max_ = value;
+        if (value < min_) min_ = value;
+    }
+
+    void reset() noexcept {
+        for (auto& c: counts_) c = 0;
+        total_ = 0;
+        max_ = 0;
+        min_ = UINT32_MAX;
+    }
+
+    uint64_t count() const noexcept { return total_; }
+    uint32_t max() const noexcept { return max_; }
+    uint32_t min() const noexcept { return total_ ? min_ : 0; }
+
+    /**
+     * @brief Smallest recorded bucket bound such that percent % of all values are at or below it
+     *
+     * @param percent Percentile in the range [0, 100], e.g. 99.9
+     * @return Upper bound of the bucket holding that percentile, never above max(); 0 if empty
+     */
+    uint32_t value_at_percentile(double percent) const noexcept {
+        if (total_ == 0) return 0;
+
+        auto rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total_) + 0.5);
+        if (rank == 0) rank = 1;
+        if (rank > total_) rank = total_;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; i++) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                auto upper = upper_bound_of(i);
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+    /**
+     * @brief Visits every non-empty bucket as f(lower_bound, upper_bound, count), for export
+     */
+    template <typename F>
+    void for_each_bucket(F&& f) const {
+        for (size_t i = 0; i < bucket_count; i++) {
+            if (counts_[i] != 0) f(lower_bound_of(i), upper_bound_of(i), counts_[i]);
+        }
+    }
+
+    static constexpr size_t index_of(uint32_t value) noexcept {
+        unsigned width = std::bit_width(value);
+        if (width <= SubBits + 1) {
+            return value;
+        }
+        unsigned shift = width - 1 - SubBits;
+        return (size_t(shift + 1) << SubBits) + ((value >> shift) & ((1u << SubBits) - 1));
+    }
+    static constexpr uint32_t lower_bound_of(size_t index) noexcept {
+        size_t block = index >> SubBits;
+        uint32_t sub = index & ((1u << SubBits) - 1);
+        if (block <= 1) {
+            return static_cast<uint32_t>(index);
+        }
+        return ((1u << SubBits) + sub) << (block - 1);
+    }
+    static constexpr uint32_t upper_bound_of(size_t index) noexcept {
+        size_t block = index >> SubBits;
+        if (block <= 1) {
+            return static_cast<uint32_t>(index);
+        }
+        return lower_bound_of(index) + ((1u << (block - 1)) - 1);
+    }
+
+private:
+    Count counts_[bucket_count]{};
+    uint64_t total_ = 0;
+    uint32_t max_ = 0;
+    uint32_t min_ = UINT32_MAX;
+};
+
+/**
+ * @brief Stand-in for a histogram when latency recording is disabled
+ */
+struct no_histogram {
+    void record(uint32_t) noexcept {}
+    void reset() noexcept {}
+    uint64_t count() const noexcept { return 0; }
+};
+
+}
+
+#endif // CORONIMO_HISTOGRAM_H_
@@ -0,0 +1,337 @@
+#ifndef CORONIMO_LOG_H_
+#define CORONIMO_LOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace adva::coronimo {
+
+/**
+ * @file log.h
+ * @brief Deferred binary logging
+ *
+ * @details Logging a message stores the pointer to its format string and the raw
+ * argument words into a ring; nothing is formatted on the calling path. Format strings
+ * must therefore outlive the ring, string literals being the intended use, and so must
+ * the strings passed for %s when the log is formatted on the target.
+ *
+ * Entries are turned into text later, either on the target by draining the ring from a
+ * low-priority task, or on the host from a dump processed by tools/log2text.
+ *
+ * Arguments are integers, enums and pointers of at most pointer size. The printf
+ * conversions d i u x X o c p s and % are understood together with flags, width and
+ * precision; length modifiers are accepted and ignored since every argument is a word.
+ *
+ * Example, draining from a background task:
+ * @code
+ * async_task log_printer() {
+ *     for ( ; ; ) {
+ *         S::log_buffer().drain([](uint32_t, char const* text, size_t n) { uart_write(text, n); }, 4);
+ *         co_await yield_awaitable<S>{};
+ *     }
+ * }
+ * @endcode
+ */
+
+template <size_t Args>
+struct log_entry {
+    uint32_t timestamp;     ///< cycle_counter reading
+    uint8_t argc;
+    char const* format;
+    uintptr_t args[Args];
+};
+
+struct log_dump_header {
+    static constexpr uint32_t magic_value = 0x474f4c43; // "CLOG"
+    static constexpr uint16_t version_value = 1;
+
+    static constexpr uint8_t string_tag = 'S';   ///< pointer, uint16_t length, characters
+    static constexpr uint8_t entry_tag = 'E';    ///< uint32_t timestamp, uint8_t argc, format pointer, args
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t pointer_size;        ///< sizeof(uintptr_t) on the target
+    uint8_t reserved;
+    uint32_t cycles_per_us;      ///< cycle_counter rate, 0 if unknown
+    uint32_t count;              ///< Number of entries that follow
+    uint32_t lost;               ///< Entries overwritten before the dump
+};
+
+namespace detail {
+
+template <typename T>
+constexpr uintptr_t log_word(T v) noexcept {
+    if constexpr (std::is_null_pointer_v<T>) {
+        return 0;
+    } else if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uintptr_t>(v);
+    } else if constexpr (std::is_enum_v<T>) {
+        return log_word(static_cast<std::underlying_type_t<T>>(v));
+    } else {
+        static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(uintptr_t),
+            "log arguments must be integers, enums or pointers of at most pointer size");
+        if constexpr (std::is_signed_v<T>) {
+            return static_cast<uintptr_t>(static_cast<intptr_t>(v));
+        } else {
+            return static_cast<uintptr_t>(v);
+        }
+    }
+}
+
+}
+
+/**
+ * @brief Formats one log message into out
+ *
+ * @param args Argument words, zero-extended to 64 bits
+ * @param arg_size Size of an argument word where it was recorded, to sign-extend %d
+ * @param strings Whether %s arguments point to readable strings; false on the host,
+ *                which prints their addresses instead
+ * @return Length of the text in out, which is always terminated if size is not 0
+ */
+inline size_t format_log_message(char* out, size_t size, char const* format, uint64_t const* args, size_t argc,
+                                 size_t arg_size = sizeof(uintptr_t), bool strings = true) noexcept {
+    size_t pos = 0;
+    size_t next = 0;
+
+    auto dest = [&] { return pos < size ? out + pos : nullptr; };
+    auto room = [&] { return pos < size ? size - pos : 0; };
+    auto append = [&](int n) { if (n > 0) pos += static_cast<size_t>(n); };
+
+    while (*format) {
+        if (*format != '%') {
+            char const* start = format;
+            while (*format && *format != '%') format++;
+            size_t n = static_cast<size_t>(format - start);
+            if (room() > 1) std::memcpy(out + pos, start, n < room() - 1 ? n : room() - 1);
+            pos += n;
+            continue;
+        }
+
+        char spec[16] = "%";
+        size_t k = 1;
+        format++;
+        while (*format && std::strchr("-+ #0123456789.", *format) && k < 8) spec[k++] = *format++;
+        while (*format && std::strchr("hlzjtL", *format)) format++;
+
+        char conv = *format;
+        if (!conv) break;
+        format++;
+        if (conv == '%') {
+            append(std::snprintf(dest(), room(), "%%"));
+            continue;
+        }
+        if (!std::strchr("diuxXocsp", conv)) {
+            // Kept as is without taking an argument, so the following ones stay aligned
+            append(std::snprintf(dest(), room(), "%%%c", conv));
+            continue;
+        }
+
+        uint64_t v = next < argc ? args[next++] : 0;
+        switch (conv) {
+            case 'd': case 'i': {
+                unsigned shift = arg_size < 8 ? 64 - 8 * static_cast<unsigned>(arg_size) : 0;
+                auto s = static_cast<long long>(static_cast<int64_t>(v << shift) >> shift);
+                std::memcpy(spec + k, "lld", 4);
+                append(std::snprintf(dest(), room(), spec, s));
+                break;
+            }
+            case 'u': case 'x': case 'X': case 'o':
+                spec[k++] = 'l';
+                spec[k++] = 'l';
+                spec[k++] = conv;
+                spec[k] = '\0';
+                append(std::snprintf(dest(), room(), spec, static_cast<unsigned long long>(v)));
+                break;
+            case 'c':
+                spec[k++] = 'c';
+                spec[k] = '\0';
+                append(std::snprintf(dest(), room(), spec, static_cast<int>(v)));
+                break;
+            case 's':
+                if (strings && v != 0) {
+                    spec[k++] = 's';
+                    spec[k] = '\0';
+                    append(std::snprintf(dest(), room(), spec, reinterpret_cast<char const*>(static_cast<uintptr_t>(v))));
+                    break;
+                }
+                [[fallthrough]];
+            case 'p':
+                append(std::snprintf(dest(), room(), "0x%llx", static_cast<unsigned long long>(v)));
+                break;
+        }
+    }
+
+    if (size == 0) return 0;
+    if (pos >= size) pos = size - 1;
+    out[pos] = '\0';
+    return pos;
+}
+
+/**
+ * @brief Lock-free ring of deferred log entries
+ *
+ * @tparam Counter CycleCounter providing timestamps
+ * @tparam N Capacity in entries, must be a power of two
+ * @tparam Args Maximum number of arguments per message
+ *
+ * Any number of writers (tasks, interrupt handlers) may log concurrently with a single
+ * reader draining or dumping. When the ring is full the oldest entries are overwritten
+ * and counted as lost; an entry being written while it is read may come out garbled.
+ */
+template <typename Counter, size_t N, size_t Args = 4>
+class log_ring {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "log ring size must be a power of two");
+    static_assert(Args < 256, "too many log arguments");
+
+public:
+    using entry_type = log_entry<Args>;
+
+    /// Longest line drain() produces, longer messages are truncated
+    static constexpr size_t line_size = 128;
+
+    template <typename... A>
+    void record(char const* format, A... args) noexcept {
+        static_assert(sizeof...(A) <= Args, "too many log arguments");
+
+        uint32_t i = head_.fetch_add(1, std::memory_order_relaxed);
+        auto& e = entries_[i & (N - 1)];
+        e.timestamp = Counter::now();
+        e.argc = sizeof...(A);
+        e.format = format;
+        [[maybe_unused]] size_t k = 0;
+        ((e.args[k++] = detail::log_word(args)), ...);
+    }
+
+    /**
+     * @brief Formats and removes up to max of the oldest entries
+     *
+     * @param sink Called as sink(uint32_t timestamp, char const* text, size_t length)
+     * @return Number of entries handed to the sink
+     */
+    template <typename F>
+    size_t drain(F&& sink, size_t max = SIZE_MAX) {
+        size_t done = 0;
+        char line[line_size];
+
+        while (done < max) {
+            uint32_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_ > N) {
+                lost_ += head - N - tail_;
+                tail_ = head - N;
+            }
+            if (tail_ == head) break;
+
+            entry_type e = entries_[tail_ & (N - 1)];
+            if (head_.load(std::memory_order_relaxed) - tail_ > N) {
+                // Overwritten while being copied, the loop above accounts for it
+                continue;
+            }
+            tail_++;
+
+            uint64_t args[Args ? Args : 1];
+            for (size_t i = 0; i < e.argc; i++) args[i] = e.args[i];
+            size_t n = format_log_message(line, sizeof(line), e.format, args, e.argc);
+            sink(e.timestamp, static_cast<char const*>(line), n);
+            done++;
+        }
+        return done;
+    }
+
+    /// Number of entries not yet drained
+    size_t size() const noexcept {
+        uint32_t pending = head_.load(std::memory_order_relaxed) - tail_;
+        return pending < N ? pending : N;
+    }
+    static constexpr size_t capacity() noexcept { return N; }
+
+    /// Entries overwritten before they were drained
+    uint32_t lost() const noexcept { return lost_; }
+
+    void clear() noexcept {
+        tail_ = head_.load(std::memory_order_relaxed);
+        lost_ = 0;
+    }
+
+    /**
+     * @brief Writes the pending entries without draining them, for tools/log2text
+     *
+     * The dump is a log_dump_header followed by tagged chunks. Each distinct format
+     * string is written once, before the first entry using it, so the dump can be
+     * formatted without the target's image. Finding repeats costs a scan over the
+     * preceding entries, which is acceptable for an occasional dump.
+     *
+     * @param write Callable invoked as write(void const* data, size_t size), possibly
+     *              several times
+     * @param cycles_per_us Rate of the cycle counter stored in the header, 0 if unknown
+     */
+    template <typename W>
+    void dump(W&& write, uint32_t cycles_per_us = 0) const {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t first = head - tail_ > N ? head - N : tail_;
+
+        log_dump_header header{
+            log_dump_header::magic_value,
+            log_dump_header::version_value,
+            sizeof(uintptr_t),
+            0,
+            cycles_per_us,
+            head - first,
+            lost_ + (first - tail_),
+        };
+        write(static_cast<void const*>(&header), sizeof(header));
+
+        for (uint32_t i = first; i != head; i++) {
+            auto const& e = entries_[i & (N - 1)];
+
+            bool seen = false;
+            for (uint32_t j = first; j != i && !seen; j++) {
+                seen = entries_[j & (N - 1)].format == e.format;
+            }
+            if (!seen) {
+                size_t length = std::strlen(e.format);
+                auto n = static_cast<uint16_t>(length < UINT16_MAX ? length : UINT16_MAX);
+                write(static_cast<void const*>(&log_dump_header::string_tag), 1);
+                write(static_cast<void const*>(&e.format), sizeof(e.format));
+                write(static_cast<void const*>(&n), sizeof(n));
+                write(static_cast<void const*>(e.format), n);
+            }
+
+            write(static_cast<void const*>(&log_dump_header::entry_tag), 1);
+            write(static_cast<void const*>(&e.timestamp), sizeof(e.timestamp));
+            write(static_cast<void const*>(&e.argc), sizeof(e.argc));
+            write(static_cast<void const*>(&e.format), sizeof(e.format));
+            write(static_cast<void const*>(e.args), e.argc * sizeof(uintptr_t));
+        }
+    }
+
+private:
+    std::atomic<uint32_t> head_{0};
+    uint32_t tail_ = 0;
+    uint32_t lost_ = 0;
+    entry_type entries_[N]{};
+};
+
+/**
+ * @brief Stand-in for log_ring when logging is disabled; every call compiles away
+ */
+struct no_log {
+    template <typename... A>
+    void record(char const*, A...) noexcept {}
+    template <typename F>
+    size_t drain(F&&, size_t = SIZE_MAX) { return 0; }
+    size_t size() const noexcept { return 0; }
+    static constexpr size_t capacity() noexcept { return 0; }
+    uint32_t lost() const noexcept { return 0; }
+    void clear() noexcept {}
+    template <typename W>
+    void dump(W&&, uint32_t = 0) const {}
+};
+
+}
+
+#endif // CORONIMO_LOG_H_
@@ -0,0 +1,260 @@
+#ifndef CORONIMO_READY_QUEUE_H_
+#define CORONIMO_READY_QUEUE_H_
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <etl/intrusive_links.h>
+#include <etl/intrusive_list.h>
+
+namespace adva::coronimo {
+
+/**
+ * @file ready_queue.h
+ * @brief Ready queue policies of the scheduler
+ *
+ * @details A ready queue holds the promises of SCHEDULED tasks and decides which one
+ * run_once() resumes next. The scheduler picks the policy from its config; every policy
+ * provides the same interface:
+ * - push(P&), pop() returning the next task or nullptr, erase(P&) of a queued task
+ * - empty(), size() and for_each(f)
+ *
+ * Per-task state a policy needs lives in the promise as a hook object of the policy's
+ * hook type, reached through P::ready_hook(). Queues are bounded by the task registry,
+ * so pushing never allocates and never fails.
+ */
+
+struct fifo_hook {};
+
+/**
+ * @brief First come, first served; the default policy
+ *
+ * Links tasks through the promise's etl::bidirectional_link<0>.
+ */
+template <typename P>
+class fifo_ready_queue {
+public:
+    using hook_type = fifo_hook;
+
+    void push(P& p) { list_.push_back(p); }
+    P* pop() {
+        if (list_.empty()) return nullptr;
+        auto& p = list_.front();
+        list_.pop_front();
+        return &p;
+    }
+    void erase(P& p) { list_.erase(p); }
+
+    bool empty() const { return list_.empty(); }
+    size_t size() const { return list_.size(); }
+
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& p: list_) f(p);
+    }
+
+private:
+    etl::intrusive_list<P, etl::bidirectional_link<0>> list_;
+};
+
+/**
+ * @brief Per-task state of the EDF policy
+ *
+ * @tparam T time_type of the deadline clock
+ */
+template <typename T>
+struct edf_hook {
+    T deadline{};
+    bool has_deadline = false;
+    bool missed = false;       ///< The current deadline was already counted as missed
+    uint32_t index = 0;        ///< Position in the heap while queued
+    uint32_t seq = 0;          ///< Enqueue order, keeps equal deadlines first come, first served
+    uint32_t misses = 0;       ///< Deadlines this task missed
+};
+
+/**
+ * @brief Earliest deadline first, as a bounded binary heap
+ *
+ * Tasks without a deadline rank after all tasks with one and run in the order they were
+ * scheduled. Deadlines are ordered with the clock's time_type comparison, so a clock that
+ * wraps must not have deadlines more than half its range apart.
+ *
+ * @tparam P Promise type, with ready_hook() returning an edf_hook
+ * @tparam N Capacity, the scheduler's max_task_count
+ */
+template <typename P, size_t N>
+class edf_ready_queue {
+public:
+    void push(P& p) {
+        auto& hook = p.ready_hook();
+        hook.seq = seq_++;
+        hook.index = static_cast<uint32_t>(size_);
+        heap_[size_++] = &p;
+        sift_up(hook.index);
+    }
+    P* pop() {
+        if (size_ == 0) return nullptr;
+        P* top = heap_[0];
+        remove_at(0);
+        return top;
+    }
+    void erase(P& p) {
+        remove_at(p.ready_hook().index);
+    }
+    /// Restores the heap order after the deadline of a queued task changed
+    void update(P& p) {
+        size_t i = p.ready_hook().index;
+        sift_up(i);
+        sift_down(p.ready_hook().index);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    template <typename F>
+    void for_each(F&& f) {
+        for (size_t i = 0; i < size_; i++) f(*heap_[i]);
+    }
+
+private:
+    static bool before(P* a, P* b) {
+        auto& x = a->ready_hook();
+        auto& y = b->ready_hook();
+        if (x.has_deadline != y.has_deadline) return x.has_deadline;
+        if (x.has_deadline) {
+            auto order = x.deadline <=> y.deadline;
+            if (order != 0) return order < 0;
+        }
+        return static_cast<int32_t>(x.seq - y.seq) < 0;
+    }
+
+    void place(size_t i, P* p) {
+        heap_[i] = p;
+        p->ready_hook().index = static_cast<uint32_t>(i);
+    }
+    void sift_up(size_t i) {
+        P* p = heap_[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(p, heap_[parent])) break;
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, p);
+    }
+    void sift_down(size_t i) {
+        P* p = heap_[i];
+        for ( ; ; ) {
+            size_t child = 2 * i + 1;
+            if (child >= size_) break;
+            if (child + 1 < size_ && before(heap_[child + 1], heap_[child])) child++;
+            if (!before(heap_[child], p)) break;
+            place(i, heap_[child]);
+            i = child;
+        }
+        place(i, p);
+    }
+    void remove_at(size_t i) {
+        P* last = heap_[--size_];
+        if (i == size_) return;
+        place(i, last);
+        sift_up(i);
+        sift_down(last->ready_hook().index);
+    }
+
+    P* heap_[N]{};
+    size_t size_ = 0;
+    uint32_t seq_ = 0;
+};
+
+/**
+ * @brief Per-task state of the priority policy
+ */
+struct priority_hook {
+    uint32_t enqueued_at = 0;   ///< Scheduling decision count when the task was queued
+    uint8_t level = 0;          ///< Queue the task is in
+};
+
+/**
+ * @brief One FIFO per priority level, optionally with aging
+ *
+ * Without aging the highest non-empty level always runs first. With aging every queued
+ * task gains one level of effective priority per Aging scheduling decisions it waits;
+ * each decision compares the heads of all levels, the oldest tasks of their level, by
+ * level * Aging + wait and runs the largest, the older one on a tie. A task's wait
+ * starts over whenever it is queued again, i.e. after it ran.
+ *
+ * This is a constant number of comparisons per decision and bounds the wait of any ready
+ * task to (Levels - 1) * Aging + 2 * max_task_count decisions: everything that runs
+ * ahead of a task must have been queued at most (Levels - 1) * Aging decisions after it.
+ *
+ * @tparam P Promise type, with priority() returning the task's level and ready_hook()
+ *           returning a priority_hook
+ * @tparam Levels Number of priority levels
+ * @tparam Aging Scheduling decisions per level of promotion, 0 for strict priorities
+ */
+template <typename P, size_t Levels, uint32_t Aging>
+class priority_ready_queue {
+    static_assert(Levels != 0 && Levels <= 256, "unsupported number of priority levels");
+
+public:
+    void push(P& p) {
+        auto& hook = p.ready_hook();
+        size_t level = static_cast<size_t>(p.priority());
+        hook.level = static_cast<uint8_t>(level < Levels ? level : Levels - 1);
+        hook.enqueued_at = decisions_;
+        lists_[hook.level].push_back(p);
+        size_++;
+    }
+    P* pop() {
+        if (size_ == 0) return nullptr;
+
+        size_t best = Levels;
+        if constexpr (Aging == 0) {
+            best = Levels - 1;
+            while (lists_[best].empty()) best--;
+        } else {
+            uint64_t best_rank = 0;
+            uint32_t best_wait = 0;
+            for (size_t level = Levels; level-- > 0; ) {
+                if (lists_[level].empty()) continue;
+                uint32_t wait = decisions_ - lists_[level].front().ready_hook().enqueued_at;
+                uint64_t rank = uint64_t(level) * Aging + wait;
+                if (best == Levels || rank > best_rank || (rank == best_rank && wait > best_wait)) {
+                    best = level;
+                    best_rank = rank;
+                    best_wait = wait;
+                }
+            }
+        }
+
+        decisions_++;
+        auto& p = lists_[best].front();
+        lists_[best].pop_front();
+        size_--;
+        return &p;
+    }
+    void erase(P& p) {
+        lists_[p.ready_hook().level].erase(p);
+        size_--;
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& list: lists_) {
+            for (auto& p: list) f(p);
+        }
+    }
+
+private:
+    etl::intrusive_list<P, etl::bidirectional_link<0>> lists_[Levels];
+    size_t size_ = 0;
+    uint32_t decisions_ = 0;
+};
+
+}
+
+#endif // CORONIMO_READY_QUEUE_H_
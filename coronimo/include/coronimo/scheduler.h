@@ -1,13 +1,21 @@
 #ifndef ADVAOS_SCHEDULER_H_
 #define ADVAOS_SCHEDULER_H_
 
+#include <cassert>
 #include <coroutine>
 #include <functional>
+#include <new>
 #include <utility>
 #include <compare>
 #include <tuple>
+#include <source_location>
 #include <coronimo/utility.h>
 #include <coronimo/direct_tuple.h>
+#include <coronimo/trace.h>
+#include <coronimo/histogram.h>
+#include <coronimo/frame_stats.h>
+#include <coronimo/log.h>
+#include <coronimo/ready_queue.h>
 #include <etl/variant.h>
 #include <etl/flat_set.h>
 #include <etl/queue.h>
@@ -15,6 +23,7 @@
 #include <etl/intrusive_links.h>
 #include <etl/intrusive_forward_list.h>
 #include <etl/intrusive_list.h>
+#include <etl/vector.h>
 
 #ifdef coronimo_DEBUG
 
@@ -46,6 +55,301 @@ class scheduler;
 template <typename S>
 class async_task;
 
+template <typename S, typename T>
+class async_generator;
+
+template <typename S>
+class task_group_base;
+
+template <typename S, auto F>
+class persistent_task;
+
+/**
+ * @brief Free-running cycle counter used to time scheduler internals
+ * 
+ * now() is expected to wrap around; only differences of two readings are used.
+ * On Cortex-M this would typically read DWT->CYCCNT.
+ */
+template <typename T>
+concept CycleCounter = requires {
+    { T::now() } -> std::convertible_to<uint32_t>;
+};
+
+struct null_cycle_counter {
+    static uint32_t now() { return 0; }
+};
+
+/**
+ * @brief Per-task runtime accounting, all times in cycle_counter ticks
+ */
+struct task_stats {
+    uint32_t resumes = 0;            ///< Number of times the task was resumed
+    uint64_t run_cycles = 0;         ///< Total time spent running
+    uint32_t max_slice_cycles = 0;   ///< Longest single run between two suspensions
+    uint64_t queue_cycles = 0;       ///< Total time spent SCHEDULED before running
+    uint32_t max_queue_cycles = 0;   ///< Longest single wait in the scheduled queue
+
+    uint32_t queued_at = 0;          ///< Counter reading when the task was last scheduled
+};
+
+struct no_task_stats {};
+
+/**
+ * @brief One frame of a task's async stack
+ * 
+ * @tparam L std::source_location, or detail::no_location when await_locations is disabled
+ */
+template <typename L>
+struct async_frame {
+    void* address;   ///< Coroutine frame address
+    L location;      ///< co_await the frame is suspended at
+};
+
+/**
+ * @brief A slice that ran longer than its budget, as recorded by the watchdog
+ */
+struct slice_overrun {
+    void* task;               ///< Frame address of the offending task
+    void* frame;              ///< Innermost async_func frame the task suspended in, or the task frame
+    size_t callstack_depth;   ///< Number of nested async_func frames at suspension
+    uint32_t cycles;          ///< Length of the slice
+    uint32_t budget;          ///< Budget it exceeded
+};
+
+using slice_overrun_hook = void (*)(slice_overrun const&);
+
+template <uint32_t N>
+struct slice_overrun_log {
+    slice_overrun log[N];
+    uint32_t count = 0;
+};
+
+namespace detail {
+
+struct empty {};
+
+/// Converts a clock duration (an arithmetic type or one with count()) into a clamped tick count
+template <typename D>
+constexpr uint32_t duration_ticks(D const& d) {
+    auto ticks = [&] { 
+        if constexpr (requires { d.count(); }) return d.count(); else return d; 
+    }();
+    if (ticks <= decltype(ticks){0}) return 0;
+    if (ticks >= static_cast<decltype(ticks)>(UINT32_MAX)) return UINT32_MAX;
+    return static_cast<uint32_t>(ticks);
+}
+
+/// Stands in for std::source_location when await locations are not recorded
+struct no_location {
+    constexpr char const* file_name() const noexcept { return ""; }
+    constexpr char const* function_name() const noexcept { return ""; }
+    constexpr uint_least32_t line() const noexcept { return 0; }
+    constexpr uint_least32_t column() const noexcept { return 0; }
+};
+
+/**
+ * @brief Forwards the awaiter interface to an awaiter held by reference, or by value when
+ *        it is the prvalue result of operator co_await
+ */
+template <typename Awaiter>
+struct await_forwarder {
+    Awaiter awaiter;
+
+    bool await_ready() { return awaiter.await_ready(); }
+    template <typename H>
+    decltype(auto) await_suspend(H h) { return awaiter.await_suspend(h); }
+    decltype(auto) await_resume() { return awaiter.await_resume(); }
+};
+
+template <typename A>
+decltype(auto) get_awaiter(A& a) {
+    if constexpr (requires { a.operator co_await(); }) {
+        return a.operator co_await();
+    } else {
+        return (a);
+    }
+}
+
+/**
+ * @brief Promise base recording where the coroutine last co_awaited
+ * 
+ * The enabled variant declares await_transform, which the compiler then calls for every
+ * co_await in the coroutine body; the defaulted argument captures the call site. The
+ * operand stays where it is and is reached through an await_forwarder, so awaitables are
+ * neither copied nor moved.
+ */
+template <bool Enabled>
+struct await_site_recorder {
+    no_location await_location() const noexcept { return {}; }
+};
+
+template <>
+struct await_site_recorder<true> {
+    template <typename A>
+    auto await_transform(A&& a, std::source_location loc = std::source_location::current()) noexcept {
+        await_site_ = loc;
+        return await_forwarder<decltype(get_awaiter(a))>{ get_awaiter(a) };
+    }
+    std::source_location await_location() const noexcept { return await_site_; }
+
+private:
+    std::source_location await_site_;
+};
+
+template <typename C>
+struct config_cycle_counter { using type = null_cycle_counter; };
+
+template <typename C>
+struct config_deadline_clock { 
+    using type = empty; 
+    using time_type = empty;
+};
+
+template <typename C> requires requires { typename C::deadline_clock; }
+struct config_deadline_clock<C> { 
+    using type = C::deadline_clock; 
+    using time_type = C::deadline_clock::time_type;
+};
+
+template <typename C> requires requires { typename C::cycle_counter; }
+struct config_cycle_counter<C> { using type = C::cycle_counter; };
+
+}
+
+/**
+ * @brief Optional scheduler features, resolved from a SchedulerConfig
+ * 
+ * Every feature defaults to off when the config does not mention it:
+ * - task_stats: per-task runtime accounting (requires cycle_counter)
+ * - trace_size: capacity of the binary trace ring, 0 disables tracing (requires cycle_counter)
+ * - wakeup_histograms: latency from event activation and timer deadline to the waiter's
+ *   resume (the event path requires cycle_counter)
+ * - slice_budget: enables the slice-overrun watchdog; the default budget of every task in
+ *   cycles, 0 for no default so that only tasks with their own budget are checked
+ *   (requires cycle_counter)
+ * - overrun_log_size: number of slice overruns kept, 8 by default
+ * - await_locations: remember the source location of the co_await every task and
+ *   async_func is suspended at, reported by the async stack walk
+ * - frame_stats: coroutine frame size telemetry, totals and high-water marks over all
+ *   frames, per coroutine function and per task (see frame_stats.h)
+ * - frame_stats_functions: number of coroutine functions tracked individually, 16 by default
+ * - log_size: capacity of the deferred log ring scheduler internals log into, 0 disables
+ *   logging; timestamps stay 0 without a cycle_counter (see log.h)
+ * - log_args: maximum number of arguments per log message, 4 by default
+ * - deadline_clock: a Clock type; selects the earliest-deadline-first ready queue, with
+ *   task deadlines in its time_type (see ready_queue.h)
+ * - priority_scheduling: selects a ready queue per task_priority level, higher levels first
+ * - priority_aging: scheduling decisions after which a waiting task is promoted by one
+ *   level, bounding the wait of every ready task; implies priority_scheduling
+ * - handoff_limit: number of tasks a single run_once() may hand off to in a row after
+ *   event::activate_handoff(), ahead of the deadline and priority order, 4 by default,
+ *   0 disables handoffs
+ * - cycle_counter: a CycleCounter type timing the above
+ * - cycles_per_us: cycle_counter rate, only used to annotate dumps
+ * 
+ * Only needs the scheduler type to be declared, so it is usable from types
+ * that are instantiated while the scheduler itself is still incomplete.
+ */
+template <typename S>
+struct scheduler_traits;
+
+template <SchedulerConfig C>
+struct scheduler_traits<scheduler<C>> {
+    using config_type = C;
+
+    static constexpr bool task_stats = [] { 
+        if constexpr (requires { C::task_stats; }) return bool(C::task_stats); else return false;
+    }();
+
+    static constexpr size_t trace_size = [] { 
+        if constexpr (requires { C::trace_size; }) return size_t(C::trace_size); else return size_t(0);
+    }();
+
+    static constexpr bool wakeup_histograms = [] { 
+        if constexpr (requires { C::wakeup_histograms; }) return bool(C::wakeup_histograms); else return false;
+    }();
+
+    static constexpr bool await_locations = [] { 
+        if constexpr (requires { C::await_locations; }) return bool(C::await_locations); else return false;
+    }();
+
+    static constexpr bool slice_watchdog = requires { C::slice_budget; };
+
+    static constexpr uint32_t slice_budget = [] { 
+        if constexpr (requires { C::slice_budget; }) return uint32_t(C::slice_budget); else return uint32_t(0);
+    }();
+
+    static constexpr uint32_t overrun_log_size = [] { 
+        if constexpr (requires { C::overrun_log_size; }) return uint32_t(C::overrun_log_size); else return uint32_t(8);
+    }();
+
+    static constexpr bool frame_stats = [] { 
+        if constexpr (requires { C::frame_stats; }) return bool(C::frame_stats); else return false;
+    }();
+
+    static constexpr size_t frame_stats_functions = [] { 
+        if constexpr (requires { C::frame_stats_functions; }) return size_t(C::frame_stats_functions); else return size_t(16);
+    }();
+
+    static constexpr size_t log_size = [] { 
+        if constexpr (requires { C::log_size; }) return size_t(C::log_size); else return size_t(0);
+    }();
+
+    static constexpr size_t log_args = [] { 
+        if constexpr (requires { C::log_args; }) return size_t(C::log_args); else return size_t(4);
+    }();
+
+    static constexpr size_t handoff_limit = [] { 
+        if constexpr (requires { C::handoff_limit; }) return size_t(C::handoff_limit); else return size_t(4);
+    }();
+
+    static constexpr uint32_t cycles_per_us = [] { 
+        if constexpr (requires { C::cycles_per_us; }) return uint32_t(C::cycles_per_us); else return uint32_t(0);
+    }();
+
+    using deadline_clock = detail::config_deadline_clock<C>::type;
+    using deadline_type = detail::config_deadline_clock<C>::time_type;
+    static constexpr bool edf = !std::is_same_v<deadline_clock, detail::empty>;
+
+    static constexpr uint32_t priority_aging = [] { 
+        if constexpr (requires { C::priority_aging; }) return uint32_t(C::priority_aging); else return uint32_t(0);
+    }();
+
+    static constexpr bool priority_scheduling = [] { 
+        if constexpr (requires { C::priority_scheduling; }) return bool(C::priority_scheduling); else return false;
+    }() || priority_aging != 0;
+    static_assert(!(edf && priority_scheduling), "deadline_clock and priority_scheduling are exclusive");
+
+    using cycle_counter = detail::config_cycle_counter<C>::type;
+    static_assert(CycleCounter<cycle_counter>, "cycle_counter must satisfy CycleCounter");
+    static constexpr bool has_cycle_counter = !std::is_same_v<cycle_counter, null_cycle_counter>;
+    static_assert(!task_stats || !std::is_same_v<cycle_counter, null_cycle_counter>, 
+        "task_stats requires a cycle_counter");
+    static_assert(trace_size == 0 || !std::is_same_v<cycle_counter, null_cycle_counter>, 
+        "tracing requires a cycle_counter");
+    static_assert(!wakeup_histograms || !std::is_same_v<cycle_counter, null_cycle_counter>, 
+        "wakeup_histograms requires a cycle_counter");
+    static_assert(!slice_watchdog || !std::is_same_v<cycle_counter, null_cycle_counter>, 
+        "slice_budget requires a cycle_counter");
+    static_assert(overrun_log_size != 0, "overrun_log_size must not be 0");
+    static_assert(frame_stats_functions != 0 && frame_stats_functions < UINT16_MAX, 
+        "frame_stats_functions out of range");
+
+    using task_stats_type = std::conditional_t<task_stats, coronimo::task_stats, no_task_stats>;
+    using trace_type = std::conditional_t<trace_size != 0, trace_ring<cycle_counter, trace_size>, no_trace>;
+    using histogram_type = std::conditional_t<wakeup_histograms, log_linear_histogram<>, no_histogram>;
+    using location_type = std::conditional_t<await_locations, std::source_location, detail::no_location>;
+    using slice_budget_type = std::conditional_t<slice_watchdog, uint32_t, detail::empty>;
+    using slice_start_type = std::conditional_t<has_cycle_counter, uint32_t, detail::empty>;
+    using ready_hook_type = std::conditional_t<edf, edf_hook<deadline_type>, 
+        std::conditional_t<priority_scheduling, priority_hook, fifo_hook>>;
+    using overrun_log_type = std::conditional_t<slice_watchdog, slice_overrun_log<overrun_log_size>, detail::empty>;
+    using frame_registry_type = std::conditional_t<frame_stats, frame_registry<frame_stats_functions>, detail::empty>;
+    using frame_tag_type = std::conditional_t<frame_stats, frame_tag, detail::empty>;
+    using task_frame_usage_type = std::conditional_t<frame_stats, task_frame_usage, no_task_frame_usage>;
+    using log_type = std::conditional_t<log_size != 0, log_ring<cycle_counter, log_size, log_args>, no_log>;
+};
+
 //template <typename S>
 //struct async_task<S>::struct promise_type;
 
@@ -99,28 +403,59 @@ public:
     using async_task_type = async_task<scheduler_type>;
     using async_task_handle_type = async_task_type::async_task_handle_type;
 
-    struct promise_type : public etl::forward_link<0> {
+    struct promise_type : public etl::forward_link<0>, 
+                          public detail::await_site_recorder<scheduler_traits<S>::await_locations> {
         friend async_func_type;
+        friend async_task_type;
         friend scheduler_type;
 
+        /**
+         * @brief Hands control back to the awaiting coroutine once the body has returned
+         *
+         * Pops this frame off the owning task's callstack and transfers to the
+         * continuation, so returning from a nested async_func does not grow the
+         * native stack.
+         */
+        struct final_awaitable {
+            bool await_ready() noexcept { return false; }
+            template <typename P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+                auto& p = h.promise();
+                if (p.task_handle_) {
+                    p.task_handle_.promise().callstack_pop();
+                }
+                if (p.continuation_) {
+                    return p.continuation_;
+                }
+                return std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
     public:
 
-        promise_type() : task_handle_(nullptr) {}
+        promise_type() : task_handle_(nullptr), continuation_(nullptr) {
+            if constexpr (scheduler_traits<S>::frame_stats) {
+                frame_.size = scheduler_type::frames_.take_pending_size();
+            }
+        }
         static async_func_type get_return_object_on_allocation_failure()
         {
             return async_func_type(async_func_type::null_handle);
         }
         void* operator new(std::size_t n) noexcept
         {
-            pr_debug("[" << n << "]");
-            void *mem = new char[n];
-            return mem;
+            scheduler_type::log("async_func: allocating %u byte frame", n);
+            return scheduler_type::allocate_frame(n);
         }
-        void operator delete(void* p) noexcept
+        void operator delete(void* p, std::size_t n) noexcept
         {
-            delete[] (char*)p;
+            scheduler_type::free_frame(p, n);
         }
         ~promise_type() {
+            if constexpr (scheduler_traits<S>::frame_stats) {
+                scheduler_type::frames_.release(frame_.index);
+            }
         }
 
         async_task_handle_type task_handle() {
@@ -130,30 +465,25 @@ public:
         // Promise interface
         async_func_type get_return_object() noexcept {
             auto h = async_func_handle_type::from_promise(*this);
+            scheduler_type::frame_created(h.address(), frame_);
             return async_func_type(h);
         }
         std::suspend_always initial_suspend() noexcept { 
-            pr_debug("");
             return {}; 
         }
-        std::suspend_always final_suspend() noexcept { 
-            pr_debug("");
+        final_awaitable final_suspend() noexcept { 
             return {}; 
         }
         void return_void() noexcept {
-            pr_debug("async_func: RETURN");
-
-            if (task_handle_) {
-                task_handle_.promise().callstack_pop();
-                task_handle_.promise().resume();
-            }
+            scheduler_type::log("async_func %p: return", async_func_handle_type::from_promise(*this).address());
         }
         //exception return_value(exception a);
         void unhandled_exception() { std::terminate(); }
 
-    private:
+    protected:
         async_task_handle_type task_handle_;
-
+        std::coroutine_handle<> continuation_;
+        [[no_unique_address]] scheduler_traits<S>::frame_tag_type frame_;
 
     };
 
@@ -167,24 +497,51 @@ private:
     static async_func_handle_type null_handle;
 
 public:
+    async_func(const async_func&) = delete;
+    async_func& operator=(const async_func&) = delete;
+
+    async_func(async_func&& other) noexcept 
+        : handle_(std::exchange(other.handle_, nullptr)) 
+    {}
+    async_func& operator=(async_func&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~async_func() noexcept {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
 
     bool await_ready() { return false; }
     async_func_handle_type await_suspend(async_task_handle_type awaiter_handle) {
-        pr_debug("async_func: SUSPEND FROM TASK");
+        scheduler_type::log("async_func %p: called from task %p", handle_.address(), awaiter_handle.address());
         promise().task_handle_ = awaiter_handle;
+        promise().continuation_ = awaiter_handle;
         promise().task_handle_.promise().callstack_push(promise());
         return handle_;
     }
-    async_func_handle_type await_suspend(async_func_handle_type awaiter_handle) {
-        pr_debug("async_func: SUSPEND FROM CORO");
-        promise().task_handle_ = awaiter_handle.promise().task_handle_;
+    template <typename P>
+    async_func_handle_type await_suspend(std::coroutine_handle<P> awaiter_handle) {
+        scheduler_type::log("async_func %p: called from async_func %p", handle_.address(), awaiter_handle.address());
+        promise().task_handle_ = awaiter_handle.promise().task_handle();
+        promise().continuation_ = awaiter_handle;
         promise().task_handle_.promise().callstack_push(promise());
         return handle_;
     }
     void await_resume() {
-        pr_debug("async_func: RESUME");
-        promise().task_handle_.promise().callstack_pop();
+        scheduler_type::log("async_func %p: resuming caller", handle_.address());
         promise().task_handle_ = nullptr;
+        promise().continuation_ = nullptr;
+    }
+
+    /// Size of the coroutine frame, 0 if its allocation was elided
+    uint32_t frame_size() const noexcept requires (scheduler_traits<scheduler_type>::frame_stats) {
+        return handle_ ? promise().frame_.size : 0;
     }
 
 };
@@ -245,8 +602,10 @@ public:
     //using coroutine_handle_type = std::coroutine_handle<coroutine_type::promise_type>;
 
     friend scheduler_type;
+    friend task_group_base<scheduler_type>;
 
-    struct promise_type : etl::bidirectional_link<0> {
+    struct promise_type : etl::bidirectional_link<0>, 
+                          detail::await_site_recorder<scheduler_traits<S>::await_locations> {
     private:
         //using coroutine_stack = etl::intrusive_stack<coroutine_type::promise_type, etl::forward_link<0> >;
         
@@ -256,43 +615,107 @@ public:
         friend scheduler_type;
         friend async_task_type;
         friend async_func_type;
+        friend task_group_base<scheduler_type>;
+        template <typename, auto> friend class persistent_task;
+
+        using task_stats_type = scheduler_traits<scheduler_type>::task_stats_type;
 
         task_state state_;
         task_priority priority_;
         async_func_stack callstack_;
+        task_group_base<scheduler_type>* group_ = nullptr;     ///< Group notified when the task completes
+        bool detached_ = false;                                ///< Owned by the scheduler, see spawn_detached()
+        [[no_unique_address]] task_stats_type stats_;
+        [[no_unique_address]] scheduler_traits<scheduler_type>::slice_budget_type slice_budget_{};
+        [[no_unique_address]] scheduler_traits<scheduler_type>::frame_tag_type frame_;
+        [[no_unique_address]] scheduler_traits<scheduler_type>::task_frame_usage_type frame_usage_;
+        [[no_unique_address]] scheduler_traits<scheduler_type>::ready_hook_type ready_;
 
     public:
 
-        promise_type() : state_(task_state::INACTIVE) {}
+        promise_type() : state_(task_state::INACTIVE), priority_(task_priority::MID) {
+            if constexpr (scheduler_traits<scheduler_type>::frame_stats) {
+                frame_.size = scheduler_type::frames_.take_pending_size();
+                frame_usage_.frame_size = frame_.size;
+            }
+        }
         static async_task_type get_return_object_on_allocation_failure()
         {
             return async_task_type(async_task_type::null_handle);
         }
         void* operator new(std::size_t n) noexcept
         {
-            pr_debug("[" << n << "]");
-            void *mem = new char[n];
-            return mem;
+            if (void* kept = scheduler_type::take_kept_frame(n)) {
+                scheduler_type::log("async_task: reusing %u byte frame", n);
+                if constexpr (scheduler_traits<scheduler_type>::frame_stats) {
+                    scheduler_type::frames_.on_reuse(n);
+                }
+                return kept;
+            }
+            scheduler_type::log("async_task: allocating %u byte frame", n);
+            return scheduler_type::allocate_frame(n);
         }
-        void operator delete(void* p) noexcept
+        void operator delete(void* p, std::size_t n) noexcept
         {
-            delete[] (char*)p;
+            if (scheduler_type::keep_frame(p, n)) return;
+            scheduler_type::free_frame(p, n);
         }
         ~promise_type() {
-            scheduler_type::get_instance().erase_task(*this);
+            scheduler_type::instance().erase_task(*this);
+            if constexpr (scheduler_traits<scheduler_type>::frame_stats) {
+                scheduler_type::frames_.release(frame_.index);
+            }
         }
 
         async_task_handle_type task_handle() {
             return async_task_handle_type::from_promise(*this);
         }
+        /// Per-task state of the scheduler's ready queue policy
+        auto& ready_hook() noexcept { return ready_; }
+        task_priority priority() const noexcept { return priority_; }
+
         void callstack_push(async_func_promise_type& promise) {
-            pr_debug("");
             callstack_.push(promise);
+            if constexpr (scheduler_traits<scheduler_type>::frame_stats) {
+                frame_usage_.stack_bytes += promise.frame_.size;
+                if (frame_usage_.stack_bytes > frame_usage_.peak_stack_bytes) {
+                    frame_usage_.peak_stack_bytes = frame_usage_.stack_bytes;
+                }
+            }
+            scheduler_type::trace(trace_event::func_push, async_func_handle_type::from_promise(promise).address(), 
+                task_handle().address(), static_cast<uint8_t>(callstack_.size()));
         }
         void callstack_pop() {
-            pr_debug("");
-            if (!callstack_.empty()) callstack_.pop();
+            if (callstack_.empty()) return;
+            scheduler_type::trace(trace_event::func_pop, async_func_handle_type::from_promise(callstack_.top()).address(), 
+                task_handle().address(), static_cast<uint8_t>(callstack_.size()));
+            if constexpr (scheduler_traits<scheduler_type>::frame_stats) {
+                frame_usage_.stack_bytes -= callstack_.top().frame_.size;
+            }
+            callstack_.pop();
         }
+        /**
+         * @brief Walks the async stack, innermost frame first, ending with the task frame
+         * 
+         * @param f Called as f(async_frame const&) for every frame
+         */
+        template <typename F>
+        void for_each_frame(F&& f) const {
+            using frame_type = async_frame<typename scheduler_traits<scheduler_type>::location_type>;
+            auto task = async_task_handle_type::from_promise(const_cast<promise_type&>(*this));
+
+            if (!callstack_.empty()) {
+                auto h = async_func_handle_type::from_promise(const_cast<async_func_promise_type&>(callstack_.top()));
+                for ( ; ; ) {
+                    f(frame_type{ h.address(), h.promise().await_location() });
+                    auto parent = h.promise().continuation_;
+                    if (!parent || parent.address() == task.address()) break;
+                    h = async_func_handle_type::from_address(parent.address());
+                }
+            }
+            f(frame_type{ task.address(), this->await_location() });
+        }
+
         void resume() {
             state_ = task_state::ACTIVE;
             if (callstack_.empty()) {
@@ -305,10 +728,12 @@ public:
         // Promise interface
         async_task_type get_return_object() noexcept { 
             auto h = async_task_handle_type::from_promise(*this);
-            if (!scheduler_type::get_instance().insert_task(*this)) {
-                // Warning: "this" no longer valid after coroutine is destroyed via handle_.destroy()
-                h.destroy();
-                h = async_task_type::null_handle;
+            scheduler_type::frame_created(h.address(), frame_);
+            if (!scheduler_type::task_instance().insert_task(*this)) {
+                // The frame must not be destroyed before it reaches initial_suspend, so
+                // hand it out as a zombie and let ~async_task release it
+                scheduler_type::log("task %p: task registry full, created as zombie", h.address());
+                state_ = task_state::ZOMBIE;
             }
             // Prvalue is materialized on caller's stack
             return async_task_type(h);
@@ -361,11 +786,262 @@ public:
     bool invalid() const noexcept {
         return state() == task_state::ZOMBIE;
     }
+    task_priority priority() const noexcept {
+        return handle_ ? promise().priority_ : task_priority::MID;
+    }
+    /**
+     * @brief Overrides the global slice_budget for this task, 0 reverts to the global one
+     */
+    void set_slice_budget(uint32_t cycles) noexcept requires (scheduler_traits<scheduler_type>::slice_watchdog) {
+        if (handle_) promise().slice_budget_ = cycles;
+    }
+    /**
+     * @brief Walks the task's async stack, see scheduler::for_each_async_stack()
+     */
+    template <typename F>
+    void for_each_frame(F&& f) const {
+        if (handle_) promise().for_each_frame(f);
+    }
+    /// Number of deadlines this task missed, see scheduler::set_deadline()
+    uint32_t deadline_misses() const noexcept requires (scheduler_traits<scheduler_type>::edf) {
+        return handle_ ? promise().ready_.misses : 0;
+    }
+    /// Number of async_func frames the task is currently nested in
+    size_t callstack_depth() const noexcept {
+        return handle_ ? promise().callstack_.size() : 0;
+    }
+    /**
+     * @brief Size of the task's own coroutine frame, 0 if its allocation was elided
+     * 
+     * Meant for frame budget checks in tests, e.g. assert(task.frame_size() <= 256).
+     */
+    uint32_t frame_size() const noexcept requires (scheduler_traits<scheduler_type>::frame_stats) {
+        return handle_ ? promise().frame_.size : 0;
+    }
+    /// Task frame plus the current and peak bytes of the async_func frames it awaits
+    task_frame_usage frame_usage() const noexcept requires (scheduler_traits<scheduler_type>::frame_stats) {
+        return handle_ ? promise().frame_usage_ : task_frame_usage{};
+    }
 };
 
 template <typename S>
 async_task<S>::async_task_handle_type async_task<S>::null_handle{nullptr};
 
+template <typename S, typename T>
+/**
+ * @brief A coroutine producing a sequence of values for the task awaiting it
+ * 
+ * @tparam S The scheduler type
+ * @tparam T Type of the values, handed to the consumer by reference
+ * 
+ * Each co_await next() runs the producer until its next co_yield, the same way awaiting
+ * an async_func runs it: the producer joins the awaiting task's callstack for that
+ * stretch and leaves it when it yields, so control passes straight between the two
+ * frames without a round trip through the scheduler. In between the producer may
+ * co_await anything an async_func can, timers, events and nested async_funcs included;
+ * the task is suspended and resumed inside the producer as usual.
+ * 
+ * next() returns a pointer to the yielded object, which stays in the producer's frame
+ * and is valid until the following next(), or nullptr once the producer has returned.
+ * Yielding a temporary is fine, it lives until the producer is resumed.
+ * 
+ * Usage example:
+ * @code
+ * async_generator<S, record> parse(uart& u) {
+ *     for ( ; ; ) {
+ *         record r;
+ *         co_await u.read(r);
+ *         co_yield r;
+ *     }
+ * }
+ * 
+ * async_task consume(uart& u) {
+ *     auto records = parse(u);
+ *     while (record* r = co_await records.next()) {
+ *         handle(*r);
+ *     }
+ * }
+ * @endcode
+ * 
+ * The producer starts on the first next(). A generator is consumed by one coroutine at
+ * a time and must not be awaited again before the previous next() completed.
+ */
+class async_generator {
+public:
+    struct promise_type;
+
+    using scheduler_type = S;
+    using value_type = T;
+    using async_generator_type = async_generator<scheduler_type, value_type>;
+    using async_generator_handle_type = std::coroutine_handle<promise_type>;
+
+    using async_func_type = async_func<scheduler_type>;
+    using async_func_promise_type = async_func_type::promise_type;
+    using async_func_handle_type = std::coroutine_handle<async_func_promise_type>;
+
+    static_assert(!std::is_reference_v<value_type>, "async_generator yields objects, not references");
+
+    /*
+     * The promise extends the async_func promise so the frame can sit on a task's
+     * callstack, which resumes its top through an async_func handle. That relies on the
+     * base being at the start of the promise, as it is for single inheritance; the
+     * static_asserts below and the assert in get_return_object() hold it to that.
+     */
+    struct promise_type : public async_func_promise_type {
+        friend async_generator_type;
+
+        void* operator new(std::size_t n) noexcept
+        {
+            scheduler_type::log("async_generator: allocating %u byte frame", n);
+            return scheduler_type::allocate_frame(n);
+        }
+        void operator delete(void* p, std::size_t n) noexcept
+        {
+            scheduler_type::free_frame(p, n);
+        }
+
+        async_generator_type get_return_object() noexcept {
+            auto h = async_generator_handle_type::from_promise(*this);
+            assert(async_func_handle_type::from_promise(*this).address() == h.address());
+            scheduler_type::frame_created(h.address(), this->frame_);
+            return async_generator_type(h);
+        }
+        static async_generator_type get_return_object_on_allocation_failure() {
+            return async_generator_type(async_generator_handle_type{});
+        }
+        void return_void() noexcept {
+            scheduler_type::log("async_generator %p: return", async_generator_handle_type::from_promise(*this).address());
+        }
+
+        /// Suspends the producer and hands control back to the consumer, like returning does
+        auto yield_value(value_type& value) noexcept {
+            value_ = std::addressof(value);
+            return typename async_func_promise_type::final_awaitable{};
+        }
+        auto yield_value(value_type&& value) noexcept {
+            value_ = std::addressof(value);
+            return typename async_func_promise_type::final_awaitable{};
+        }
+
+    private:
+        value_type* value_ = nullptr;
+    };
+
+    static_assert(alignof(promise_type) == alignof(async_func_promise_type), 
+        "async_generator promise must be laid out like the async_func promise");
+    static_assert(!std::is_polymorphic_v<promise_type> && sizeof(promise_type) == 
+        (sizeof(async_func_promise_type) + sizeof(value_type*) + alignof(promise_type) - 1) / alignof(promise_type) * alignof(promise_type),
+        "async_generator promise must add nothing but the yielded value to the async_func promise");
+
+    /**
+     * @brief Awaitable resuming the producer up to its next co_yield
+     */
+    struct next_awaitable {
+        bool await_ready() noexcept { 
+            return !handle_ || handle_.done(); 
+        }
+        template <typename P>
+        async_generator_handle_type await_suspend(std::coroutine_handle<P> awaiter_handle) {
+            auto& p = handle_.promise();
+            p.value_ = nullptr;
+            p.task_handle_ = awaiter_handle.promise().task_handle();
+            p.continuation_ = awaiter_handle;
+            p.task_handle_.promise().callstack_push(p);
+            return handle_;
+        }
+        value_type* await_resume() noexcept {
+            if (!handle_) {
+                return nullptr;
+            }
+            auto& p = handle_.promise();
+            p.task_handle_ = nullptr;
+            p.continuation_ = nullptr;
+            return handle_.done() ? nullptr : p.value_;
+        }
+
+        async_generator_handle_type handle_;
+    };
+
+private:
+    explicit async_generator(async_generator_handle_type h) noexcept : handle_(h) { }
+
+    async_generator_handle_type handle_;
+
+public:
+    async_generator(const async_generator&) = delete;
+    async_generator& operator=(const async_generator&) = delete;
+
+    async_generator(async_generator&& other) noexcept 
+        : handle_(std::exchange(other.handle_, nullptr)) 
+    {}
+    async_generator& operator=(async_generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~async_generator() noexcept {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    next_awaitable next() noexcept { 
+        return next_awaitable{ handle_ }; 
+    }
+    /// The producer has returned, or its frame could not be allocated
+    bool done() const noexcept { 
+        return !handle_ || handle_.done(); 
+    }
+
+    /// Size of the coroutine frame, 0 if its allocation was elided
+    uint32_t frame_size() const noexcept requires (scheduler_traits<scheduler_type>::frame_stats) {
+        return handle_ ? handle_.promise().frame_.size : 0;
+    }
+};
+
+template <typename C>
+concept Clock = requires(C c, typename C::time_type t, typename C::duration_type d) {
+    { c.now() } -> std::convertible_to<typename C::time_type>;
+    { t + d } -> std::convertible_to<typename C::time_type>;
+    { t - d } -> std::convertible_to<typename C::time_type>;
+    { t <=> t } -> std::convertible_to<std::strong_ordering>;
+    { d <=> d } -> std::convertible_to<std::strong_ordering>;
+};
+
+template <typename T, typename S>
+concept Service = requires(T s) {
+    { s.run_once() } -> std::convertible_to<bool>;
+};
+
+/**
+ * @brief Service that can tell whether it has any work at all
+ * 
+ * The run loop skips polling such services while has_pending() is false.
+ */
+template <typename T, typename S>
+concept PendingService = Service<T, S> && requires(T s) {
+    { s.has_pending() } -> std::convertible_to<bool>;
+};
+
+/**
+ * @brief Limits of one batch of tasks the run loop executes between two service polls
+ * 
+ * @tparam D Duration type of the clock driving the loop
+ */
+template <typename D>
+struct run_budget {
+    size_t tasks = 8;   ///< Tasks run per batch at most, at least 1
+    D time{};           ///< Time a batch may take, checked after every task; zero for no limit
+};
+
+enum class run_result {
+    quiescent,   ///< No task is scheduled and no service had work
+    deadline,    ///< The deadline passed
+};
+
 template <SchedulerConfig C> 
 /**
  * @brief A cooperative scheduler for managing asynchronous tasks and functions
@@ -382,6 +1058,7 @@ template <SchedulerConfig C>
  * - Task state management (SUSPENDED, SCHEDULED, ACTIVE, DONE, ZOMBIE)
  * - Safe task scheduling with duplicate prevention
  * - Cooperative multitasking through run_once() and run_one() methods
+ * - Optional per-task runtime accounting (see scheduler_traits) and a snapshot() task table
  * 
  * The scheduler maintains:
  * - A set of task handles for tracking valid tasks
@@ -404,72 +1081,584 @@ public:
     using async_task_handle_type = async_task_type::async_task_handle_type;
     using async_func_type = async_func<scheduler_type>;
     using async_func_handle_type = async_func_type::async_func_handle_type;
+    using traits_type = scheduler_traits<scheduler_type>;
+    using cycle_counter = traits_type::cycle_counter;
+    using task_stats_type = traits_type::task_stats_type;
+    using trace_type = traits_type::trace_type;
+    using histogram_type = traits_type::histogram_type;
+    using log_type = traits_type::log_type;
+    using deadline_clock = traits_type::deadline_clock;
+    using deadline_type = traits_type::deadline_type;
+    using frame_registry_type = traits_type::frame_registry_type;
+    using task_frame_usage_type = traits_type::task_frame_usage_type;
+
+    static_assert(!traits_type::edf || Clock<deadline_clock>, "deadline_clock must satisfy Clock");
 
     template <typename A, typename S> friend struct scheduler_friend;
     friend async_task_type;
     friend async_func_type;
+    template <typename S, typename T> friend class async_generator;
+    friend task_group_base<scheduler_type>;
+    template <typename S, auto F> friend class persistent_task;
+
+    /**
+     * @brief One row of the task table returned by snapshot()
+     */
+    struct task_info {
+        void* address;              ///< Coroutine frame address, identifies the task
+        task_state state;
+        task_priority priority;
+        size_t callstack_depth;     ///< Number of nested async_func frames
+        task_stats_type stats;      ///< Empty unless task_stats is enabled
+        task_frame_usage_type frames;   ///< Empty unless frame_stats is enabled
+    };
+    using task_table = etl::vector<task_info, config_type::max_task_count>;
 
 private:
     using async_task_promise_type = async_task_type::promise_type;
     using handle_set = etl::flat_set<async_task_handle_type, config_type::max_task_count>;
-    using scheduled_queue = etl::intrusive_list<async_task_promise_type, etl::bidirectional_link<0>>;
+    using scheduled_queue = std::conditional_t<traits_type::edf, 
+        edf_ready_queue<async_task_promise_type, config_type::max_task_count>, 
+        std::conditional_t<traits_type::priority_scheduling,
+            priority_ready_queue<async_task_promise_type, size_t(task_priority::ISR) + 1, traits_type::priority_aging>,
+            fifo_ready_queue<async_task_promise_type>>>;
 
     handle_set handles_;
     scheduled_queue scheduled_;
 
+    [[no_unique_address]] traits_type::overrun_log_type overruns_;
+    static inline slice_overrun_hook overrun_hook_ = nullptr;
+
+    static inline async_task_promise_type* current_ = nullptr;
+    async_task_promise_type* handoff_ = nullptr;
+    static inline deadline_clock* deadline_clock_ = nullptr;
+    [[no_unique_address]] std::conditional_t<traits_type::edf, uint32_t, detail::empty> deadline_misses_{};
+    static inline traits_type::slice_start_type slice_start_{};
+    static inline trace_type trace_{};
+    static inline histogram_type event_wakeups_{};
+    static inline frame_registry_type frames_{};
+    static inline log_type log_{};
+    static inline void* kept_frame_ = nullptr;    ///< Frame of a persistent task being restarted in place
+    static inline size_t kept_size_ = 0;          ///< Its size while it is not taken over yet
+
+    static inline scheduler_type* instance_ = nullptr;    ///< Set once get_instance() constructed it
+
 private:
-    scheduler() { }
+    scheduler() { 
+        instance_ = this;
+    }
+
+    /**
+     * @brief The scheduler instance, without the initialization guard
+     *
+     * Only valid once get_instance() has been called, which code reached from a task, its
+     * awaitables or its frame can rely on; for friends only, as nothing else can.
+     */
+    static scheduler_type& instance() noexcept { 
+        assert(instance_);
+        return *instance_; 
+    }
+    /// instance() for creating tasks, constructing the scheduler if this is the first one
+    static scheduler_type& task_instance() noexcept {
+        return instance_ ? *instance_ : get_instance();
+    }
 
     bool insert_task(async_task_promise_type& p) {
         auto h = p.task_handle();
-        if (handles_.contains(h)) return false;
+        if (h.address() == kept_frame_) {
+            // Restarted in place, still registered under the same handle
+            p.state_ = task_state::SUSPENDED;
+            return true;
+        }
+        if (handles_.full() || handles_.contains(h)) return false;
 
         p.state_ = task_state::SUSPENDED;
         auto [it, result] = handles_.insert(h); 
         return result;
     }
     bool erase_task(async_task_promise_type& p) {
+        if (handoff_ == &p) {
+            handoff_ = nullptr;
+        }
+        if (p.state_ == task_state::SCHEDULED) {
+            // Task destroyed while waiting to run, drop it from the queue as well
+            scheduled_.erase(p);
+        }
+        if (p.task_handle().address() == kept_frame_) {
+            // Restarted in place, the new coroutine takes over the registry entry
+            return true;
+        }
         return handles_.erase(p.task_handle()) ;
     }
 
-    bool schedule(async_task_handle_type& h, auto&& pred) {
-        if (!handles_.contains(h)) return false;
-
-        auto& p = h.promise();
-        if (!pred(p.state_)) return false;
-        
-        p.state_ = task_state::SCHEDULED;
-        scheduled_.push_back(p);
+    /// Keeps the memory of a frame being restarted in place instead of freeing it
+    static bool keep_frame(void* p, size_t n) noexcept {
+        if (p != kept_frame_) return false;
+        kept_size_ = n;
         return true;
     }
-    bool schedule(async_func_handle_type& handle, auto&& pred) {
-        auto task_handle = handle.promise().task_handle();
-        if (!task_handle) return false;
-        return schedule(task_handle, pred);
+    /// The kept frame, if the new coroutine fits in it
+    static void* take_kept_frame(size_t n) noexcept {
+        if (!kept_frame_ || n > kept_size_) return nullptr;
+        kept_size_ = 0;
+        return kept_frame_;
     }
 
-    bool suspend(async_task_handle_type& h, auto&& pred) {
-        if (!handles_.contains(h)) return false;
-
-        auto& p = h.promise();
-        if (!pred(p.state_)) return false;
-
-        p.state_ = task_state::SUSPENDED;
-        return true;
+    /*
+     * Memory of task and function frames. The promises' operator new and delete only
+     * forward here, so however the compiler inlines them it pairs the global sized
+     * operators below rather than a global new with a class-specific delete.
+     */
+    static void* allocate_frame(size_t n) noexcept {
+        void* mem = ::operator new(n, std::nothrow);
+        if constexpr (traits_type::frame_stats) {
+            if (mem) frames_.on_allocate(n);
+        }
+        return mem;
     }
-    bool suspend(async_func_handle_type& handle, auto&& pred) {
-        auto task_handle = handle.promise().task_handle();
-        if (!task_handle) return false;
-        return suspend(task_handle, pred);
+    static void free_frame(void* p, size_t n) noexcept {
+        if constexpr (traits_type::frame_stats) {
+            frames_.on_deallocate(n);
+        }
+        ::operator delete(p, n);
     }
 
-public:
-    static scheduler_type& get_instance() { static scheduler_type inst; return inst; }
+    /**
+     * @brief Replaces the DONE task behind h by the one create() returns and starts it
+     * 
+     * The old frame is destroyed with its memory and registry entry kept for the new
+     * coroutine, which the same coroutine function always fits in. See persistent_task.
+     */
+    template <typename F>
+    bool restart_task(async_task_handle_type& h, F&& create) {
+        auto priority = task_priority::MID;
+        if (h) {
+            if (h.promise().state_ != task_state::DONE) return false;
+            priority = h.promise().priority_;
+            kept_frame_ = h.address();
+            std::exchange(h, nullptr).destroy();
+        }
 
-    void schedule_all_suspended() {
-        for (auto& h: handles_) {
-            if (h.promise().state_ != task_state::SUSPENDED) continue;
-            scheduled_.push_back(h.promise());
+        auto task = create();
+        if (void* old = std::exchange(kept_frame_, nullptr); old && kept_size_ != 0) {
+            // Not taken over after all, release what the old frame kept
+            handles_.erase(async_task_handle_type::from_address(old));
+            async_task_promise_type::operator delete(old, std::exchange(kept_size_, 0));
+        }
+
+        if (task.state() != task_state::SUSPENDED) return false;
+        h = std::exchange(task.handle_, nullptr);
+        h.promise().priority_ = priority;
+        enqueue(h.promise());
+        return true;
+    }
+
+    /// Attributes a freshly allocated frame to its coroutine function, see frame_stats.h
+    template <typename Tag>
+    static void frame_created([[maybe_unused]] void* address, [[maybe_unused]] Tag& tag) noexcept {
+        if constexpr (traits_type::frame_stats) {
+            // Every frame starts with a pointer to the coroutine's resume function
+            tag.index = frames_.acquire(*static_cast<void const* const*>(address), tag.size);
+        }
+    }
+
+    void enqueue(async_task_promise_type& p) {
+        p.state_ = task_state::SCHEDULED;
+        if constexpr (traits_type::task_stats) {
+            p.stats_.queued_at = cycle_counter::now();
+        }
+        scheduled_.push(p);
+    }
+
+    /// Counts the task's deadline as missed if it has passed, at most once per deadline
+    void settle_deadline(async_task_promise_type& p) {
+        if constexpr (traits_type::edf) {
+            auto& hook = p.ready_;
+            if (!hook.has_deadline || hook.missed || !deadline_clock_) return;
+            if (deadline_clock_->now() > hook.deadline) {
+                hook.missed = true;
+                hook.misses++;
+                deadline_misses_++;
+                log("task %p: missed its deadline", p.task_handle().address());
+            }
+        }
+    }
+    bool change_deadline(async_task_promise_type& p, bool has_deadline, deadline_type const& deadline) {
+        if (!handles_.contains(p.task_handle())) return false;
+
+        settle_deadline(p);
+        p.ready_.has_deadline = has_deadline;
+        p.ready_.deadline = deadline;
+        p.ready_.missed = false;
+        if (p.state_ == task_state::SCHEDULED) {
+            scheduled_.update(p);
+        }
+        return true;
+    }
+
+    bool change_priority(async_task_promise_type& p, task_priority priority) {
+        if (!handles_.contains(p.task_handle())) return false;
+
+        bool requeue = traits_type::priority_scheduling && p.state_ == task_state::SCHEDULED && p.priority_ != priority;
+        if (requeue) scheduled_.erase(p);
+        p.priority_ = priority;
+        if (requeue) scheduled_.push(p);
+        return true;
+    }
+
+    /// Accounts the wait in the ready queue, before the task can queue itself again
+    void account_wait(async_task_promise_type& p, uint32_t start) {
+        if constexpr (traits_type::task_stats) {
+            auto& stats = p.stats_;
+            uint32_t queued = start - stats.queued_at;
+
+            stats.resumes++;
+            stats.queue_cycles += queued;
+            if (queued > stats.max_queue_cycles) stats.max_queue_cycles = queued;
+        }
+    }
+    void account_slice(async_task_promise_type& p, uint32_t slice) {
+        if constexpr (traits_type::task_stats) {
+            auto& stats = p.stats_;
+            stats.run_cycles += slice;
+            if (slice > stats.max_slice_cycles) stats.max_slice_cycles = slice;
+        }
+    }
+
+    void check_slice(async_task_promise_type& p, uint32_t slice) {
+        if constexpr (traits_type::slice_watchdog) {
+            uint32_t budget = p.slice_budget_ ? p.slice_budget_ : traits_type::slice_budget;
+            if (budget == 0 || slice <= budget) return;
+
+            auto& record = overruns_.log[overruns_.count++ % traits_type::overrun_log_size];
+            record.task = p.task_handle().address();
+            record.frame = p.callstack_.empty() ? record.task 
+                : async_func_handle_type::from_promise(p.callstack_.top()).address();
+            record.callstack_depth = p.callstack_.size();
+            record.cycles = slice;
+            record.budget = budget;
+
+            if (overrun_hook_) overrun_hook_(record);
+        }
+    }
+
+    /// Polls every service once, returns whether any of them did work
+    template <typename... V>
+    static bool poll_services(direct_tuple<V...>& services) {
+        bool worked = false;
+        tuple_for_each(services, [&](auto& service) {
+            using service_type = std::remove_cvref_t<decltype(service)>;
+            static_assert(Service<service_type, scheduler_type>, "not a service");
+            if constexpr (PendingService<service_type, scheduler_type>) {
+                if (!service.has_pending()) return;
+            }
+            worked |= service.run_once();
+        });
+        return worked;
+    }
+
+    template <typename K, typename... V>
+    run_result run_loop(K& clock, typename K::time_type deadline, direct_tuple<V...>& services, 
+                        run_budget<typename K::duration_type> budget) {
+        using duration_type = K::duration_type;
+        bool timed = budget.time > duration_type{};
+
+        for ( ; ; ) {
+            bool worked = poll_services(services);
+
+            if (scheduled_.empty()) {
+                if (!worked) return run_result::quiescent;
+            } else {
+                auto batch_end = timed ? clock.now() + budget.time : deadline;
+                size_t n = 0;
+                do {
+                    run_once();
+                } while (++n < budget.tasks && !scheduled_.empty() && !(timed && clock.now() >= batch_end));
+            }
+
+            if (clock.now() >= deadline) return run_result::deadline;
+        }
+    }
+
+    /**
+     * @brief Makes a task that was just scheduled run right after the current one suspends
+     * 
+     * Only honored when called from a running task; a later call replaces the target.
+     * The task must be registered, as any task just scheduled is.
+     */
+    void hand_off(async_task_handle_type& h) {
+        if constexpr (traits_type::handoff_limit != 0) {
+            if (!current_) return;
+
+            auto& p = h.promise();
+            if (&p != current_ && p.state_ == task_state::SCHEDULED) {
+                handoff_ = &p;
+            }
+        }
+    }
+
+    /// Resumes one task for one slice and settles its state afterwards
+    void dispatch(async_task_promise_type& task_promise) {
+        current_ = &task_promise;
+        trace(trace_event::task_resume, task_promise.task_handle().address());
+
+        if constexpr (traits_type::has_cycle_counter) {
+            uint32_t start = cycle_counter::now();
+            slice_start_ = start;
+            account_wait(task_promise, start);
+            task_promise.resume();
+
+            if constexpr (traits_type::task_stats || traits_type::slice_watchdog) {
+                uint32_t slice = cycle_counter::now() - start;
+
+                account_slice(task_promise, slice);
+                check_slice(task_promise, slice);
+            }
+        } else {
+            task_promise.resume();
+        }
+    
+        settle_deadline(task_promise);
+
+        bool done = task_promise.task_handle().done();
+        if (done) {
+            task_promise.state_ = task_state::DONE;
+            if (task_promise.group_) {
+                task_promise.group_->child_done();
+            }
+        } else if (task_promise.state_ == task_state::ACTIVE) {
+            // Should be either suspended or scheduled, so force zombie
+            log("task %p: suspended without a waker, now a zombie", task_promise.task_handle().address());
+            task_promise.state_ = task_state::ZOMBIE;
+        } 
+
+        trace(trace_event::task_suspend, task_promise.task_handle().address(), static_cast<uint8_t>(task_promise.state_));
+        current_ = nullptr;
+
+        if (done && task_promise.detached_) {
+            // Nobody else holds the task, free its frame and registry entry right away
+            task_promise.task_handle().destroy();
+        }
+    }
+
+    bool schedule(async_task_handle_type& h, auto&& pred) {
+        if (!handles_.contains(h)) return false;
+
+        auto& p = h.promise();
+        if (!pred(p.state_)) return false;
+        
+        enqueue(p);
+        return true;
+    }
+    template <typename P>
+    bool schedule(std::coroutine_handle<P>& handle, auto&& pred) {
+        auto task_handle = handle.promise().task_handle();
+        if (!task_handle) return false;
+        return schedule(task_handle, pred);
+    }
+
+    bool suspend(async_task_handle_type& h, auto&& pred) {
+        if (!handles_.contains(h)) return false;
+
+        auto& p = h.promise();
+        if (!pred(p.state_)) return false;
+
+        p.state_ = task_state::SUSPENDED;
+        return true;
+    }
+    template <typename P>
+    bool suspend(std::coroutine_handle<P>& handle, auto&& pred) {
+        auto task_handle = handle.promise().task_handle();
+        if (!task_handle) return false;
+        return suspend(task_handle, pred);
+    }
+
+public:
+    /**
+     * @brief The scheduler instance, constructed on first use
+     *
+     * A function-local static, so it may be used during static initialization, e.g. by
+     * tasks created from constructors of other statics. It cannot be constinit: the ETL
+     * containers it holds have no constexpr constructors. Each call checks the
+     * initialization guard, which the scheduler's own paths skip once it exists.
+     */
+    static scheduler_type& get_instance() noexcept { 
+        static scheduler_type inst; 
+        return inst; 
+    }
+    /**
+     * @brief Records a trace event attributed to the running task, if tracing is enabled
+     */
+    static void trace(trace_event kind, void const* subject, uint8_t arg = 0) noexcept {
+        if constexpr (traits_type::trace_size != 0) {
+            trace_.record(kind, subject, current_ ? current_->task_handle().address() : nullptr, arg);
+        }
+    }
+    static void trace(trace_event kind, void const* subject, void const* task, uint8_t arg) noexcept {
+        if constexpr (traits_type::trace_size != 0) {
+            trace_.record(kind, subject, task, arg);
+        }
+    }
+    /**
+     * @brief Logs a message into the deferred log, if logging is enabled
+     * 
+     * Only the format pointer and the argument words are stored, see log.h; the
+     * format string must be a literal.
+     */
+    template <typename... A>
+    static void log(char const* format, A... args) noexcept {
+        if constexpr (traits_type::log_size != 0) {
+            log_.record(format, args...);
+        }
+    }
+    /// The deferred log ring, a no_log stub unless log_size is configured
+    static log_type& log_buffer() noexcept { return log_; }
+
+    /**
+     * @brief Installs a function called from run_once() right after an overrunning slice
+     * 
+     * Runs in the scheduler loop, after the offending task has suspended. Pass nullptr to remove.
+     */
+    static void set_overrun_hook(slice_overrun_hook hook) noexcept { overrun_hook_ = hook; }
+
+    /// Total number of slice overruns seen, including those no longer held in the log
+    uint32_t overrun_count() const noexcept requires (traits_type::slice_watchdog) { 
+        return overruns_.count; 
+    }
+    /// Visits the most recent overruns, oldest first
+    template <typename F>
+    void for_each_overrun(F&& f) const requires (traits_type::slice_watchdog) {
+        constexpr uint32_t n = traits_type::overrun_log_size;
+        uint32_t first = overruns_.count > n ? overruns_.count - n : 0;
+        for (uint32_t i = first; i < overruns_.count; i++) {
+            f(overruns_.log[i % n]);
+        }
+    }
+    void clear_overruns() noexcept requires (traits_type::slice_watchdog) { 
+        overruns_.count = 0; 
+    }
+
+    /// Cycles since the running task was resumed
+    static uint32_t slice_elapsed() noexcept requires (traits_type::has_cycle_counter) {
+        return cycle_counter::now() - slice_start_;
+    }
+    /// Slice budget of the running task, its own or the global one; 0 outside of tasks
+    static uint32_t current_slice_budget() noexcept requires (traits_type::slice_watchdog) {
+        if (!current_) return 0;
+        return current_->slice_budget_ ? current_->slice_budget_ : traits_type::slice_budget;
+    }
+
+    /**
+     * @brief Changes the priority of a task, all tasks start at MID
+     * 
+     * Only affects the order tasks run in with priority_scheduling; a queued task moves to
+     * the back of its new level and its aging starts over.
+     * 
+     * @return false if the task is not registered
+     */
+    bool set_priority(async_task_type& task, task_priority priority) {
+        return task.handle_ && change_priority(task.promise(), priority);
+    }
+    /// set_priority() for the running task
+    bool set_current_priority(task_priority priority) {
+        return current_ && change_priority(*current_, priority);
+    }
+
+    /**
+     * @brief Sets the clock deadlines are checked against, enabling missed-deadline accounting
+     * 
+     * Usually the clock of the timer_service. A deadline counts as missed when it has
+     * passed at the end of a slice of its task, or when the task replaces or clears it late.
+     */
+    void set_deadline_clock(deadline_clock& clock) noexcept requires (traits_type::edf) {
+        deadline_clock_ = &clock;
+    }
+    /**
+     * @brief Gives a task an absolute deadline; the ready task with the earliest one runs first
+     * 
+     * Tasks keep their deadline until it is replaced or cleared, typically by the task
+     * itself once the job it was given for is done, see set_current_deadline().
+     * 
+     * @return false if the task is not registered
+     */
+    bool set_deadline(async_task_type& task, deadline_type const& deadline) requires (traits_type::edf) {
+        return task.handle_ && change_deadline(task.promise(), true, deadline);
+    }
+    /// Removes the deadline of a task, which then runs after all tasks having one
+    bool clear_deadline(async_task_type& task) requires (traits_type::edf) {
+        return task.handle_ && change_deadline(task.promise(), false, deadline_type{});
+    }
+    /// set_deadline() for the running task
+    bool set_current_deadline(deadline_type const& deadline) requires (traits_type::edf) {
+        return current_ && change_deadline(*current_, true, deadline);
+    }
+    /// clear_deadline() for the running task
+    bool clear_current_deadline() requires (traits_type::edf) {
+        return current_ && change_deadline(*current_, false, deadline_type{});
+    }
+    /// Total number of missed deadlines, see set_deadline_clock()
+    uint32_t deadline_misses() const noexcept requires (traits_type::edf) {
+        return deadline_misses_;
+    }
+
+    /// The trace ring, a no_trace stub unless trace_size is configured
+    static trace_type& trace_buffer() noexcept { return trace_; }
+
+    /**
+     * @brief Cycles from event::activate() to the resume of each woken waiter
+     * 
+     * A no_histogram stub unless wakeup_histograms is configured. Timer lateness in
+     * clock units is kept separately by each timer_service, and timer waits are not
+     * recorded here.
+     */
+    static histogram_type& event_wakeup_latency() noexcept { return event_wakeups_; }
+
+    /**
+     * @brief Coroutine frame telemetry: totals, high-water marks and per-function sizes
+     * 
+     * Pools and max_task_count can be sized from totals().peak_bytes and peak_frames after
+     * a representative run; per-task figures are reported by snapshot().
+     */
+    static frame_registry_type const& frame_statistics() noexcept requires (traits_type::frame_stats) { 
+        return frames_; 
+    }
+
+    /**
+     * @brief Queues a single task that is not waiting on anything
+     * 
+     * Newly created tasks start out SUSPENDED; unlike schedule_all_suspended() this
+     * starts only the given one.
+     * 
+     * @return false if the task is invalid or not SUSPENDED
+     */
+    bool start(async_task_type& task) {
+        if (!task.handle_) return false;
+        return schedule(task.handle_, [](task_state state) { return state == task_state::SUSPENDED; });
+    }
+
+    /**
+     * @brief Hands a task that was not started yet over to the scheduler and starts it
+     * 
+     * The scheduler destroys the task's frame, freeing its memory and registry entry,
+     * within the run_once() in which the task completes; short-lived jobs thus do not
+     * hold on to either until an owner gets around to destroying them. A detached task
+     * can no longer be cancelled and one that never completes is never freed.
+     * 
+     * @return false if the task is invalid or not SUSPENDED, it then stays with the caller
+     */
+    bool spawn_detached(async_task_type&& task) {
+        if (task.state() != task_state::SUSPENDED) return false;
+
+        auto h = std::exchange(task.handle_, nullptr);
+        h.promise().detached_ = true;
+        enqueue(h.promise());
+        return true;
+    }
+
+    void schedule_all_suspended() {
+        for (auto& h: handles_) {
+            if (h.promise().state_ != task_state::SUSPENDED) continue;
+            enqueue(h.promise());
         }
     }
     bool run_once() {
@@ -480,205 +1669,1515 @@ public:
             return false;
         }
 
-        auto& task_promise = scheduled_.front();
-        scheduled_.pop_front();
-        
-        task_promise.resume();
-    
-        if (task_promise.task_handle().done()) {
-            task_promise.state_ = task_state::DONE;
-        } else if (task_promise.state_ == task_state::ACTIVE) {
-            // Should be either suspended or scheduled, so force zombie
-            task_promise.state_ = task_state::ZOMBIE;
-        } 
-        return true;
+        dispatch(*scheduled_.pop());
+
+        // A task woken by event::activate_handoff() runs next, bypassing the queue
+        for (size_t n = 0; n < traits_type::handoff_limit && handoff_; n++) {
+            auto& p = *std::exchange(handoff_, nullptr);
+            if (p.state_ != task_state::SCHEDULED) break;
+
+            scheduled_.erase(p);
+            dispatch(p);
+        }
+        handoff_ = nullptr;
+        return true;
+    }
+
+    /**
+     * @brief Runs tasks and polls services until the deadline or until nothing is left to do
+     * 
+     * Runs batches of up to budget.tasks scheduled tasks, or fewer if a batch exceeds
+     * budget.time, and polls every service between two batches. Services are passed as a
+     * direct_tuple and called directly; a PendingService is skipped while it has nothing
+     * pending. The deadline is checked after every batch, so it may be exceeded by up to
+     * one batch.
+     * 
+     * Returns quiescent as soon as no task is scheduled and a full round of polls did no
+     * work, e.g. to let the caller sleep until the next interrupt; timers that are armed
+     * but not yet due do not count as work, so a caller that has no timer interrupt
+     * should sleep until timer_service::next_expiry() rather than call again at once.
+     * 
+     * Usage example:
+     * @code
+     * for ( ; ; ) {
+     *     if (sched.run_for(clock, 10ms, direct_tuple{timers}) == run_result::quiescent) {
+     *         time_type next;
+     *         if (timers.next_expiry(next)) {
+     *             arm_wakeup(next);
+     *         }
+     *         wait_for_interrupt();
+     *     }
+     * }
+     * @endcode
+     * 
+     * @param services direct_tuple of services, usually holding references
+     */
+    template <Clock K, typename... V>
+    run_result run_until(K& clock, typename K::time_type deadline, direct_tuple<V...>&& services, 
+                         run_budget<typename K::duration_type> budget = {}) {
+        return run_loop(clock, deadline, services, budget);
+    }
+    template <Clock K, typename... V>
+    run_result run_until(K& clock, typename K::time_type deadline, direct_tuple<V...>& services, 
+                         run_budget<typename K::duration_type> budget = {}) {
+        return run_loop(clock, deadline, services, budget);
+    }
+    /// run_until() with a deadline relative to now
+    template <Clock K, typename... V>
+    run_result run_for(K& clock, typename K::duration_type duration, direct_tuple<V...>&& services, 
+                       run_budget<typename K::duration_type> budget = {}) {
+        return run_loop(clock, clock.now() + duration, services, budget);
+    }
+    template <Clock K, typename... V>
+    run_result run_for(K& clock, typename K::duration_type duration, direct_tuple<V...>& services, 
+                       run_budget<typename K::duration_type> budget = {}) {
+        return run_loop(clock, clock.now() + duration, services, budget);
+    }
+
+    /**
+     * @brief Lists every registered task, like a tiny top
+     * 
+     * Must not be called from within a task if consistent callstack depths are needed;
+     * the running task is reported as ACTIVE.
+     */
+    task_table snapshot() {
+        task_table table;
+        for (auto& h: handles_) {
+            auto& p = h.promise();
+            table.push_back(task_info{ 
+                h.address(), p.state_, p.priority_, p.callstack_.size(), p.stats_, p.frame_usage_
+            });
+        }
+        return table;
+    }
+
+    /**
+     * @brief Dumps the async stack of every registered task
+     * 
+     * For each task the frames are visited innermost first, the task frame last. With
+     * await_locations enabled every frame carries the co_await it is suspended at, so
+     * calling this periodically also yields a sampling profile of where tasks wait.
+     * The running task, if called from one, reports the location of its previous await.
+     * 
+     * @param f Called as f(void* task, task_state state, size_t level, async_frame const& frame)
+     */
+    template <typename F>
+    void for_each_async_stack(F&& f) {
+        for (auto& h: handles_) {
+            auto& p = h.promise();
+            size_t level = 0;
+            p.for_each_frame([&](auto const& frame) { f(h.address(), p.state_, level++, frame); });
+        }
+    }
+
+    /**
+     * @brief Checks the consistency of task states and the scheduled queue
+     * 
+     * Intended for tests and debug builds; must not be called from within a task.
+     * 
+     * @return true if every queued task is registered and SCHEDULED, every SCHEDULED
+     *         task is queued exactly once, no task is ACTIVE and DONE tasks are finished
+     */
+    bool check_invariants() {
+        if (handles_.size() > config_type::max_task_count) return false;
+
+        size_t queued = 0;
+        bool valid = true;
+        scheduled_.for_each([&](async_task_promise_type& p) {
+            if (!handles_.contains(p.task_handle())) valid = false;
+            if (p.state_ != task_state::SCHEDULED) valid = false;
+            queued++;
+        });
+        if (!valid || queued != scheduled_.size()) return false;
+
+        size_t scheduled = 0;
+        for (auto& h: handles_) {
+            switch (h.promise().state_) {
+                case task_state::SCHEDULED: scheduled++; break;
+                case task_state::ACTIVE: return false;
+                case task_state::DONE: if (!h.done()) return false; break;
+                default: break;
+            }
+        }
+        return queued == scheduled;
+    }
+
+    void run_one() {
+        schedule_all_suspended();
+
+        for ( ; ; ) {
+            run_once();
+        }
+    }
+};
+
+template <typename H, typename S>
+concept Handle = requires(H& h) {
+    { h.promise().task_handle() } -> std::convertible_to<typename S::async_task_handle_type>;
+};
+
+template <typename A, typename S>
+concept Awaitable = requires(A a, S::async_task_handle_type h) {
+    { a.await_ready() } -> std::convertible_to<bool>;
+    { a.await_suspend(h) };
+    { a.await_resume() };
+};
+
+
+/**
+ * @brief A friend class providing scheduling functionality for derived classes.
+ * 
+ * This class provides a common interface for scheduling and managing tasks within a scheduler system.
+ * It ensures that derived classes are either Awaitable or Service compatible with the scheduler.
+ * 
+ * @tparam D The derived class type
+ * @tparam S The scheduler type
+ * 
+ * @note The derived class must satisfy either Awaitable<D, S> or Service<D, S> concept
+ */
+template <typename D, typename S>
+struct scheduler_friend {
+    using async_task_handle_type = S::async_task_handle_type;
+
+    scheduler_friend(scheduler_friend const& other) = delete;
+    scheduler_friend& operator=(scheduler_friend const& other) = delete;
+    scheduler_friend() { 
+        static_assert(Awaitable<D, S> || Service<D, S>, "derived class is not compatible");
+    }
+
+protected:
+    template <Handle<S> H>
+    bool schedule_if_active(H& h) { 
+        return S::instance().schedule(h, [](task_state state) { return state == task_state::ACTIVE; }); 
+    }
+    template <Handle<S> H>
+    bool schedule_if_suspended(H& h) { 
+        return S::instance().schedule(h, [](task_state state) { return state == task_state::SUSPENDED; }); 
+    }
+    template <Handle<S> H>
+    bool suspend_if_active(H& h) { 
+        return S::instance().suspend(h, [](task_state state) {return state == task_state::ACTIVE; }); 
+    }
+    template <Handle<S> H>
+    void hand_off(H& h) {
+        S::instance().hand_off(h);
+    }
+};
+
+/**
+ * @brief An awaitable that yields control back to the scheduler
+ * 
+ * This awaitable allows a coroutine to voluntarily give up its execution time
+ * to allow other coroutines to run. When awaited, it suspends the current
+ * task and reschedules it for later execution.
+ * 
+ * @tparam S The scheduler type this awaitable works with
+ */
+template <typename S>
+struct yield_awaitable : public scheduler_friend<yield_awaitable<S>, S> {
+public:
+    using async_task_handle_type = S::async_task_handle_type;
+    using base_type = scheduler_friend<yield_awaitable<S>, S>;
+
+    // Awaitable interface
+    bool await_ready() { return false; }
+    template <Handle<S> H>
+    bool await_suspend(H h) { return base_type::schedule_if_active(h); }
+    void await_resume()  {}
+};
+
+/**
+ * @brief A yield that only suspends once the running task has used up its budget
+ * 
+ * Meant for long computations that would otherwise have to choose between yielding
+ * every iteration and starving other tasks. While within budget, await_ready() is true
+ * and the co_await costs a comparison; once the budget is spent it behaves like
+ * yield_awaitable and the budget starts over when the task is resumed.
+ * 
+ * The budget is either a number of awaits, or a time in cycle_counter ticks measured
+ * from the start of the current slice. A time budget is checked against the slice
+ * elapsed so far plus the length of the previous iteration, so a slice rarely overruns
+ * it. Without an explicit time the task's slice_budget is used.
+ * 
+ * The object keeps its state across awaits, so it is created once and awaited in the loop:
+ * @code
+ * auto pace = maybe_yield_awaitable<S>::iterations(64);
+ * for (auto& block: blocks) {
+ *     crc = update(crc, block);
+ *     co_await pace;
+ * }
+ * @endcode
+ * 
+ * @tparam S The scheduler type this awaitable works with
+ */
+template <typename S>
+struct maybe_yield_awaitable : public scheduler_friend<maybe_yield_awaitable<S>, S> {
+public:
+    using base_type = scheduler_friend<maybe_yield_awaitable<S>, S>;
+    using traits_type = scheduler_traits<S>;
+
+    /// Suspends on every n-th await
+    static maybe_yield_awaitable iterations(uint32_t n) noexcept { 
+        return maybe_yield_awaitable(n, 0); 
+    }
+    /// Suspends once the slice would exceed the given number of cycles
+    static maybe_yield_awaitable cycles(uint32_t budget) noexcept requires (traits_type::has_cycle_counter) { 
+        return maybe_yield_awaitable(0, budget); 
+    }
+    /// Suspends once the slice would exceed the running task's slice_budget
+    maybe_yield_awaitable() noexcept requires (traits_type::slice_watchdog) 
+        : maybe_yield_awaitable(0, 0) 
+    {}
+
+    // Awaitable interface
+    bool await_ready() noexcept { 
+        if (iterations_ != 0) {
+            return ++count_ < iterations_;
+        }
+        if constexpr (traits_type::has_cycle_counter) {
+            uint32_t budget = cycles_;
+            if constexpr (traits_type::slice_watchdog) {
+                if (budget == 0) budget = S::current_slice_budget();
+            }
+            if (budget == 0) return true;
+
+            uint32_t now = traits_type::cycle_counter::now();
+            uint32_t iteration = now - last_;
+            last_ = now;
+            return S::slice_elapsed() + iteration < budget;
+        }
+        return false;
+    }
+    template <Handle<S> H>
+    bool await_suspend(H h) { 
+        return base_type::schedule_if_active(h); 
+    }
+    void await_resume() noexcept {
+        if (iterations_ != 0 && count_ >= iterations_) {
+            count_ = 0;
+        }
+        if constexpr (traits_type::has_cycle_counter) {
+            last_ = traits_type::cycle_counter::now();
+        }
+    }
+
+private:
+    maybe_yield_awaitable(uint32_t iterations, uint32_t cycles) noexcept 
+        : iterations_(iterations), cycles_(cycles) 
+    {
+        if constexpr (traits_type::has_cycle_counter) {
+            last_ = traits_type::cycle_counter::now();
+        }
+    }
+
+    uint32_t iterations_;
+    uint32_t cycles_;
+    uint32_t count_ = 0;
+    [[no_unique_address]] traits_type::slice_start_type last_{};
+};
+
+template <typename S, typename E>
+struct event_awaitable;
+
+/**
+ * @brief Event tasks can wait for
+ *
+ * The plain event wakes every waiting task. An awaitable created before an activation
+ * completes without suspending, even when it is awaited only afterwards, e.g. as part of
+ * an any_of_awaitable; each activation is consumed once per awaitable. Activations
+ * before an awaitable exists are not seen by it.
+ *
+ * Only awaitables whose task suspended are kept in the event's list, in the order they
+ * suspended, so activation costs nothing for awaitables that were created but are not
+ * being waited on.
+ *
+ * Other semantics are implemented as classes passing themselves as Derived; the event's
+ * awaitables then call the derived class's hooks, which may hide these of event:
+ * - insert_awaitable(a), erase_awaitable(a): the awaitable is created and destroyed
+ * - try_acquire(a): await_ready(), true to complete the co_await without suspending
+ * - park(a), unpark(a): the awaitable's task suspends on the event and resumes
+ *
+ * Derived classes must befriend their event_awaitable_type. See counting_event and
+ * latched_event.
+ *
+ * @tparam S The scheduler type
+ * @tparam Derived Class implementing the event's semantics, void for the plain event
+ */
+template <typename S, typename Derived = void> 
+struct event {
+public:
+    using scheduler_type = S;
+    using event_type = std::conditional_t<std::is_void_v<Derived>, event<S>, Derived>;
+    using event_awaitable_type = event_awaitable<scheduler_type, event_type>;
+    using awaitable_list = etl::intrusive_list<event_awaitable_type, etl::bidirectional_link<0>>;
+    using traits_type = scheduler_traits<scheduler_type>;
+
+    friend event_awaitable_type;
+
+    event() noexcept {
+        static_assert(std::is_void_v<Derived> || std::derived_from<Derived, event<S, Derived>>, 
+            "Derived class must be derived from event");
+    }
+
+    /**
+     * @brief Activates the event, waking every task suspended on it
+     * 
+     * Every awaitable existing at that point sees the activation once, whether its task
+     * is suspended on the event or gets to the co_await later. Only the former count:
+     * returns true if a suspended task was woken, and false if the activation was only
+     * recorded, even though awaitables created before it will complete without
+     * suspending. A task whose awaitable was woken through another event, e.g. another
+     * arm of an any_of_awaitable, is not woken again.
+     */
+    bool activate() { 
+        return notify_all(false);
+    }
+    /**
+     * @brief Activates the event and, if that woke exactly one task, lets it run next
+     * 
+     * The woken task is resumed right after the calling task suspends, within the same
+     * run_once() and ahead of all other ready tasks, which gives ping-pong protocols
+     * about the latency of a function call. Has the effect of activate() when called
+     * outside of a task or when handoffs are disabled by handoff_limit.
+     * 
+     * The handoff bypasses the ready queue's order altogether: the woken task runs ahead
+     * of tasks with earlier deadlines under EDF and of higher priority tasks, for up to
+     * handoff_limit handoffs in a row, after which the next woken task is queued as usual.
+     * Configure handoff_limit as 0 where that order must hold strictly.
+     */
+    bool activate_handoff() { 
+        return notify_all(true);
+    }
+    /**
+     * @brief Whether the event was activated and no task suspended on it since
+     * 
+     * Stays true after an activation that woke tasks, until one suspends again. It tells
+     * nothing about a particular awaitable, which tracks the activations it consumed.
+     */
+    bool is_active() { 
+        return active_; 
+    }
+
+    auto create_awaitable(bool auto_activate = false) noexcept { 
+        return event_awaitable_type(static_cast<event_type&>(*this), auto_activate); 
+    }
+    auto operator co_await() noexcept { return create_awaitable(); }
+
+protected:
+    void insert_awaitable(event_awaitable_type& a) {
+        a.generation_ = generation_;
+    }
+    void erase_awaitable(event_awaitable_type& a) {
+        dequeue_awaitable(a);
+    }
+    bool try_acquire(event_awaitable_type& a) {
+        return a.generation_ != generation_;
+    }
+    void park(event_awaitable_type& a) {
+        active_ = false;
+        queue_awaitable(a);
+    }
+    void unpark(event_awaitable_type& a) {
+        dequeue_awaitable(a);
+        a.generation_ = generation_;
+    }
+
+    /// Records the activation for tracing and wakeup latency
+    void activated() {
+        if constexpr (traits_type::wakeup_histograms) {
+            activated_at_ = traits_type::cycle_counter::now();
+        }
+        scheduler_type::trace(trace_event::event_activate, this);
+    }
+
+    bool notify_all(bool handoff) {
+        active_ = true; 
+        generation_++;
+        activated();
+        return notify_parked(handoff) != 0;
+    }
+
+    /*
+     * The list holds parked awaitables only. One whose task was woken by something else,
+     * e.g. another branch of an any_of_awaitable, is dropped when reached, which keeps
+     * picking the next waiter amortized O(1).
+     */
+    void queue_awaitable(event_awaitable_type& a) {
+        awaitables_.push_back(a);
+    }
+    void dequeue_awaitable(event_awaitable_type& a) {
+        if (a.is_linked()) {
+            awaitables_.erase(a);
+            a.clear();
+        }
+    }
+    event_awaitable_type* pop_awaitable() {
+        auto& a = awaitables_.front();
+        awaitables_.pop_front();
+        a.clear();
+        return &a;
+    }
+
+    /// Wakes the task waiting longest, returns false if there is none
+    bool notify_one(bool handoff) {
+        while (!awaitables_.empty()) {
+            auto* a = pop_awaitable();
+            if (a->notify()) {
+                if (handoff) {
+                    a->hand_off();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+    /// Wakes all parked tasks, returns how many
+    size_t notify_parked(bool handoff) {
+        event_awaitable_type* woken = nullptr;
+        size_t count = 0;
+        while (!awaitables_.empty()) {
+            auto* a = pop_awaitable();
+            if (a->notify()) {
+                woken = a;
+                count++;
+            }
+        }
+        if (handoff && count == 1) {
+            woken->hand_off();
+        }
+        return count;
+    }
+
+    bool active_ = false;
+    uint32_t generation_ = 0;    ///< Activations so far
+    awaitable_list awaitables_;
+    [[no_unique_address]] std::conditional_t<traits_type::wakeup_histograms, uint32_t, detail::empty> activated_at_{};
+};
+
+template <typename S, typename E = event<S>>
+struct event_awaitable : public scheduler_friend<event_awaitable<S, E>, S>, public etl::bidirectional_link<0> {
+public:
+    using scheduler_type = S;
+    using event_type = E;
+    using async_task_handle_type = scheduler_type::async_task_handle_type;
+    using base_type = scheduler_friend<event_awaitable<S, E>, S>;
+
+    template <typename, typename>
+    friend struct event;
+
+    event_awaitable(event_type& e, bool auto_activate = false) : event_(e) {
+        e.insert_awaitable(*this);
+        if (auto_activate) {
+            e.activate();
+        }
+    }
+    ~event_awaitable() { 
+        event_.erase_awaitable(*this);
+    }
+
+    void hand_off() {
+        if (handle_) {
+            base_type::hand_off(handle_);
+        }
+    }
+    bool notify() { 
+        if (!handle_) {
+            return false;
+        }
+        bool woken = base_type::schedule_if_suspended(handle_);
+        if constexpr (traits_type::wakeup_histograms) {
+            woken_ = woken;
+        }
+        return woken;
+    }
+
+    // Awaitable interface 
+    bool await_ready() { 
+        return event_.try_acquire(*this); 
+    }
+    template <Handle<S> H>
+    bool await_suspend(H h) {
+        handle_ = h.promise().task_handle();
+        bool suspended = base_type::suspend_if_active(h);
+        event_.park(*this);
+        return suspended;
+    }
+    void await_resume() {
+        event_.unpark(*this);
+        handle_ = nullptr;
+        if constexpr (traits_type::wakeup_histograms) {
+            if (woken_) {
+                scheduler_type::event_wakeup_latency().record(traits_type::cycle_counter::now() - event_.activated_at_);
+                woken_ = false;
+            }
+        }
+    }
+    /// Keeps the pending resume out of event_wakeup_latency(), for owners recording their own
+    void skip_wakeup_record() noexcept {
+        if constexpr (traits_type::wakeup_histograms) {
+            woken_ = false;
+        }
+    }
+
+private:
+    using traits_type = scheduler_traits<scheduler_type>;
+
+    event_type& event_;
+    async_task_handle_type handle_;
+    uint32_t generation_ = 0;    ///< Activations of a plain event consumed by this awaitable
+    [[no_unique_address]] std::conditional_t<traits_type::wakeup_histograms, bool, detail::empty> woken_{};
+};
+
+/**
+ * @brief Event waking one task per activation and buffering up to N activations
+ *
+ * activate() wakes the task that has waited longest. With no task waiting the
+ * activation is counted instead and a later co_await consumes it without suspending;
+ * activations beyond N are dropped and activate() returns false. Unlike with the plain
+ * event, activating before the waiter reaches its co_await loses nothing, which suits
+ * signals from interrupt handlers and distributing work among several tasks.
+ *
+ * A task destroyed after it was woken, but before it resumed, takes its activation
+ * along.
+ *
+ * @tparam N Activations kept while no task waits
+ */
+template <typename S, size_t N>
+struct counting_event : public event<S, counting_event<S, N>> {
+public:
+    using base_type = event<S, counting_event<S, N>>;
+    using event_awaitable_type = base_type::event_awaitable_type;
+
+    static_assert(N != 0 && N <= UINT32_MAX, "unsupported activation count");
+
+    friend event_awaitable_type;
+
+    bool activate() {
+        return signal(false);
+    }
+    /// Like activate(), letting the woken task run next as event::activate_handoff() does
+    bool activate_handoff() {
+        return signal(true);
+    }
+    bool is_active() {
+        return count_ != 0;
+    }
+    /// Activations waiting to be consumed
+    uint32_t count() const {
+        return count_;
+    }
+    void reset() {
+        count_ = 0;
+    }
+
+protected:
+    void insert_awaitable(event_awaitable_type&) {}
+    bool try_acquire(event_awaitable_type&) {
+        if (count_ == 0) {
+            return false;
+        }
+        count_--;
+        return true;
+    }
+    void park(event_awaitable_type& a) {
+        base_type::queue_awaitable(a);
+    }
+    void unpark(event_awaitable_type& a) {
+        base_type::dequeue_awaitable(a);
+    }
+
+private:
+    bool signal(bool handoff) {
+        base_type::activated();
+        if (base_type::notify_one(handoff)) {
+            return true;
+        }
+        if (count_ == N) {
+            return false;
+        }
+        count_++;
+        return true;
+    }
+
+    uint32_t count_ = 0;
+};
+
+/**
+ * @brief Event waking one task per activation and remembering one activation
+ */
+template <typename S>
+using auto_reset_event = counting_event<S, 1>;
+
+/**
+ * @brief Event that stays active from activate() until reset()
+ *
+ * activate() wakes every waiting task, and while the event is active co_await completes
+ * without suspending. Suits conditions that hold once reached, such as initialization
+ * being done, and signals that must not be lost before anyone waits for them.
+ */
+template <typename S>
+struct latched_event : public event<S, latched_event<S>> {
+public:
+    using base_type = event<S, latched_event<S>>;
+    using event_awaitable_type = base_type::event_awaitable_type;
+
+    friend event_awaitable_type;
+
+    /// Returns false if the event already was active
+    bool activate() {
+        return latch(false);
+    }
+    bool activate_handoff() {
+        return latch(true);
+    }
+    /// Consumes the activation, returns whether there was one
+    bool reset() {
+        bool active = base_type::active_;
+        base_type::active_ = false;
+        return active;
+    }
+
+protected:
+    void insert_awaitable(event_awaitable_type&) {}
+    bool try_acquire(event_awaitable_type&) {
+        return base_type::active_;
+    }
+    void park(event_awaitable_type& a) {
+        base_type::queue_awaitable(a);
+    }
+    void unpark(event_awaitable_type& a) {
+        base_type::dequeue_awaitable(a);
+    }
+
+private:
+    bool latch(bool handoff) {
+        if (base_type::active_) {
+            return false;
+        }
+        base_type::active_ = true;
+        base_type::activated();
+        base_type::notify_parked(handoff);
+        return true;
+    }
+};
+
+/**
+ * @brief Single value handed from one task to the task awaiting it
+ *
+ * The oneshot lives with the receiver, typically as a local of the awaiting coroutine, so
+ * the value is stored in its frame and nothing is allocated. The receiver hands a sender
+ * to whoever produces the value and co_awaits the oneshot, which yields a pointer to the
+ * value, or nullptr when the sender was destroyed without sending:
+ * @code
+ * oneshot<reply, S> r;
+ * modem.submit(command{ ..., r.get_sender() });
+ * if (reply* p = co_await r) { ... }
+ * @endcode
+ *
+ * send() constructs the value in place and wakes the receiver, once. Either side may go
+ * away first: a destroyed sender completes the oneshot as broken, a destroyed oneshot
+ * disconnects its sender, whose send() then returns false.
+ *
+ * @tparam T Type of the value
+ * @tparam S The scheduler type
+ */
+template <typename T, typename S>
+class oneshot : public scheduler_friend<oneshot<T, S>, S> {
+public:
+    using scheduler_type = S;
+    using value_type = T;
+    using async_task_handle_type = scheduler_type::async_task_handle_type;
+    using base_type = scheduler_friend<oneshot<T, S>, S>;
+
+    static_assert(!std::is_reference_v<value_type> && !std::is_void_v<value_type>, "oneshot carries an object");
+
+    /**
+     * @brief Producing end of a oneshot, movable and at most one per oneshot
+     */
+    class sender {
+    public:
+        sender() noexcept = default;
+        sender(sender const&) = delete;
+        sender& operator=(sender const&) = delete;
+
+        sender(sender&& other) noexcept : oneshot_(std::exchange(other.oneshot_, nullptr)) {
+            if (oneshot_) {
+                oneshot_->sender_ = this;
+            }
+        }
+        sender& operator=(sender&& other) noexcept {
+            if (this != &other) {
+                drop();
+                oneshot_ = std::exchange(other.oneshot_, nullptr);
+                if (oneshot_) {
+                    oneshot_->sender_ = this;
+                }
+            }
+            return *this;
+        }
+        ~sender() {
+            drop();
+        }
+
+        /**
+         * @brief Constructs the value from args inside the oneshot and wakes the receiver
+         * @return false if the oneshot was gone or a value was already sent
+         */
+        template <typename... A>
+        bool send(A&&... args) {
+            auto* o = release();
+            if (!o) {
+                return false;
+            }
+            new (&o->value_) value_type(std::forward<A>(args)...);
+            o->complete(status::value);
+            return true;
+        }
+        /// Whether send() would still reach a receiver
+        bool connected() const noexcept {
+            return oneshot_ != nullptr;
+        }
+
+    private:
+        friend oneshot;
+
+        explicit sender(oneshot* o) noexcept : oneshot_(o) {
+            o->sender_ = this;
+        }
+
+        oneshot* release() noexcept {
+            auto* o = std::exchange(oneshot_, nullptr);
+            if (o) {
+                o->sender_ = nullptr;
+            }
+            return o;
+        }
+        void drop() {
+            if (auto* o = release()) {
+                o->complete(status::broken);
+            }
+        }
+
+        oneshot* oneshot_ = nullptr;
+    };
+
+    oneshot() noexcept {}
+    ~oneshot() {
+        if (sender_) {
+            sender_->oneshot_ = nullptr;
+        }
+        if (status_ == status::value) {
+            value_.~value_type();
+        }
+    }
+
+    /// The sender of this oneshot; a disconnected one if it was already handed out
+    sender get_sender() noexcept {
+        if (sender_ || status_ != status::empty) {
+            return sender{};
+        }
+        return sender{this};
+    }
+    /// The value was sent, or the sender is gone
+    bool ready() const noexcept {
+        return status_ != status::empty;
+    }
+    /// The value if it was sent, nullptr otherwise
+    value_type* get() noexcept {
+        return status_ == status::value ? &value_ : nullptr;
+    }
+
+    // Awaitable interface
+    bool await_ready() noexcept {
+        return ready();
+    }
+    template <Handle<S> H>
+    bool await_suspend(H h) {
+        handle_ = h.promise().task_handle();
+        return base_type::suspend_if_active(h);
+    }
+    value_type* await_resume() noexcept {
+        handle_ = nullptr;
+        return get();
+    }
+
+private:
+    enum class status : uint8_t { empty, value, broken };
+
+    void complete(status s) {
+        status_ = s;
+        if (handle_) {
+            base_type::schedule_if_suspended(handle_);
+        }
+    }
+
+    union {
+        value_type value_;
+    };
+    sender* sender_ = nullptr;
+    async_task_handle_type handle_;
+    status status_ = status::empty;
+};
+
+enum class topic_overflow : uint8_t {
+    lag,            ///< Publishing overwrites the oldest message, subscribers that fall behind skip ahead
+    backpressure,   ///< Publishing fails while a subscriber has not read the oldest message yet
+};
+
+/**
+ * @brief Result of reading a topic
+ */
+template <typename T>
+struct topic_read {
+    T const* message;   ///< The message, nullptr if the subscriber was woken without one
+    uint32_t missed;    ///< Messages overwritten before the subscriber got to them, skipped
+
+    explicit operator bool() const noexcept { return message != nullptr; }
+};
+
+/**
+ * @brief Fixed-capacity broadcast of messages to any number of subscribers
+ *
+ * Each message is constructed once in a ring of N slots and read in place by every
+ * subscriber at its own cursor. A subscriber starts with the first message published
+ * after it subscribed; co_await next() yields the message following the one read before:
+ * @code
+ * topic<sample, 8, S> samples;
+ *
+ * async_task filter() {
+ *     decltype(samples)::subscriber sub{samples};
+ *     for ( ; ; ) {
+ *         auto r = co_await sub.next();
+ *         if (r.missed) { ... }
+ *         if (r) process(*r.message);
+ *     }
+ * }
+ * @endcode
+ *
+ * Subscribers waiting for a message share one event, activated on publish. What happens
+ * to a subscriber that falls N messages behind depends on Overflow:
+ * - lag: the publisher never waits. The subscriber's next read skips the overwritten
+ *   messages and reports how many it missed. A message read must be used before the
+ *   subscriber suspends, since the publisher may overwrite it meanwhile.
+ * - backpressure: publish() returns false while the ring is full of messages some
+ *   subscriber has not read; the publisher can co_await space() for one to be read.
+ *   A message read stays valid until the subscriber's next next().
+ *
+ * Checking for space looks at every subscriber. The topic must outlive its subscribers.
+ *
+ * @tparam T Type of the messages
+ * @tparam N Number of slots, a power of two
+ * @tparam S The scheduler type
+ * @tparam Overflow What happens to subscribers that fall behind
+ */
+template <typename T, size_t N, typename S, topic_overflow Overflow = topic_overflow::lag>
+class topic {
+public:
+    using scheduler_type = S;
+    using value_type = T;
+    using topic_type = topic<T, N, S, Overflow>;
+    using read_type = topic_read<T>;
+    using event_type = event<scheduler_type>;
+    using event_awaitable_type = event_type::event_awaitable_type;
+
+    static_assert(N != 0 && (N & (N - 1)) == 0 && N <= UINT32_MAX / 2, "topic size must be a power of two");
+
+    class subscriber;
+
+    /**
+     * @brief Awaitable of a subscriber's next message
+     */
+    struct next_awaitable {
+        next_awaitable(subscriber& sub) noexcept 
+            : subscriber_(sub), 
+              awaitable_(sub.topic_.published_.create_awaitable()) 
+        {
+            sub.release();
+        }
+
+        // Awaitable interface
+        bool await_ready() noexcept { 
+            return subscriber_.available() != 0; 
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            return awaitable_.await_suspend(h);
+        }
+        read_type await_resume() noexcept {
+            awaitable_.await_resume();
+            return subscriber_.take();
+        }
+
+    private:
+        subscriber& subscriber_;
+        event_awaitable_type awaitable_;
+    };
+
+    class subscriber : public etl::bidirectional_link<0> {
+    public:
+        explicit subscriber(topic_type& t) noexcept : topic_(t), cursor_(t.head_) {
+            t.subscribers_.push_back(*this);
+        }
+        subscriber(subscriber const&) = delete;
+        subscriber& operator=(subscriber const&) = delete;
+
+        ~subscriber() {
+            topic_.subscribers_.erase(*this);
+            topic_.freed();
+        }
+
+        /// Releases the message read last and waits for the following one
+        next_awaitable next() noexcept { 
+            return next_awaitable(*this); 
+        }
+        /// Messages published and not read yet, counting those overwritten meanwhile
+        uint32_t available() const noexcept { 
+            return topic_.head_ - cursor_ - (holding_ ? 1 : 0); 
+        }
+        /// Messages this subscriber missed so far
+        uint32_t missed() const noexcept { 
+            return missed_; 
+        }
+
+    private:
+        friend topic_type;
+
+        void release() {
+            if (holding_) {
+                holding_ = false;
+                cursor_++;
+                topic_.freed();
+            }
+        }
+        read_type take() {
+            if (cursor_ == topic_.head_) {
+                return { nullptr, 0 };
+            }
+            uint32_t missed = 0;
+            if constexpr (Overflow == topic_overflow::lag) {
+                if (topic_.head_ - cursor_ > N) {
+                    missed = topic_.head_ - cursor_ - N;
+                    cursor_ = topic_.head_ - N;
+                    missed_ += missed;
+                }
+            }
+            holding_ = true;
+            return { &topic_.slot(cursor_), missed };
+        }
+
+        topic_type& topic_;
+        uint32_t cursor_;          ///< Sequence number of the message held or read next
+        bool holding_ = false;     ///< The message at cursor_ was handed out by the last next()
+        uint32_t missed_ = 0;
+    };
+
+    /**
+     * @brief Awaitable completing once publish() can succeed, see topic_overflow::backpressure
+     */
+    struct space_awaitable {
+        space_awaitable(topic_type& t) noexcept : topic_(t), awaitable_(t.space_.create_awaitable()) {}
+
+        // Awaitable interface
+        bool await_ready() noexcept {
+            if (topic_.writable()) {
+                return true;
+            }
+            topic_.full_ = true;
+            return false;
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            return awaitable_.await_suspend(h);
+        }
+        /// Whether there is space, false if woken otherwise
+        bool await_resume() noexcept {
+            awaitable_.await_resume();
+            return topic_.writable();
+        }
+
+    private:
+        topic_type& topic_;
+        event_awaitable_type awaitable_;
+    };
+
+    topic() noexcept {}
+    topic(topic const&) = delete;
+    topic& operator=(topic const&) = delete;
+
+    ~topic() {
+        for (uint32_t i = head_ - size_; i != head_; i++) {
+            slot(i).~value_type();
+        }
+    }
+
+    /**
+     * @brief Constructs a message from args in the ring and wakes the waiting subscribers
+     * @return false if the ring is full, only with topic_overflow::backpressure
+     */
+    template <typename... A>
+    bool publish(A&&... args) {
+        if (!writable()) {
+            full_ = true;
+            return false;
+        }
+        auto* p = &slot(head_);
+        if (size_ == N) {
+            p->~value_type();
+        } else {
+            size_++;
+        }
+        new (p) value_type(std::forward<A>(args)...);
+        head_++;
+        published_.activate();
+        return true;
+    }
+    /// Whether publish() would succeed
+    bool writable() const noexcept {
+        if constexpr (Overflow == topic_overflow::backpressure) {
+            for (auto const& sub: subscribers_) {
+                if (head_ - sub.cursor_ >= N) return false;
+            }
+        }
+        return true;
+    }
+    space_awaitable space() noexcept {
+        return space_awaitable(*this);
+    }
+
+    static constexpr size_t capacity() noexcept { return N; }
+    /// Messages published so far, wrapping around
+    uint32_t published() const noexcept { return head_; }
+
+private:
+    value_type& slot(uint32_t seq) noexcept {
+        return *std::launder(reinterpret_cast<value_type*>(slots_ + (seq & (N - 1)) * sizeof(value_type)));
+    }
+    /// A subscriber moved on, wake publishers waiting for space
+    void freed() {
+        if (full_) {
+            full_ = false;
+            space_.activate();
+        }
+    }
+
+    alignas(value_type) unsigned char slots_[N * sizeof(value_type)];
+    uint32_t head_ = 0;    ///< Sequence number of the next message
+    uint32_t size_ = 0;    ///< Slots holding a message
+    bool full_ = false;    ///< A publisher found the ring full since a subscriber last moved on
+    etl::intrusive_list<subscriber, etl::bidirectional_link<0>> subscribers_;
+    event_type published_;
+    event_type space_;
+};
+
+/**
+ * @brief Fixed set of N objects lent to tasks one at a time
+ *
+ * The objects are constructed with the pool and live as long as it does. A task borrows
+ * one with co_await acquire(), which completes at once while an object is free and
+ * otherwise suspends until one is returned. Waiters are served in the order they
+ * suspended; a returned object goes straight to the first of them, so a task acquiring
+ * meanwhile cannot overtake them. The handle acquire() yields returns the object when
+ * it is destroyed:
+ * @code
+ * object_pool<packet, 4, S> packets;
+ *
+ * async_task transmit() {
+ *     auto p = co_await packets.acquire();
+ *     fill(*p);
+ *     co_await radio.send(*p);
+ * }
+ * @endcode
+ *
+ * A returned object keeps its contents. Acquiring and returning are O(1). The pool must
+ * outlive its handles.
+ *
+ * @tparam T Type of the objects, default constructible
+ * @tparam N Number of objects
+ * @tparam S The scheduler type
+ */
+template <typename T, size_t N, typename S>
+class object_pool {
+public:
+    using scheduler_type = S;
+    using value_type = T;
+    using pool_type = object_pool<T, N, S>;
+    using async_task_handle_type = scheduler_type::async_task_handle_type;
+
+    static_assert(N != 0 && N <= UINT32_MAX, "unsupported pool size");
+
+    /**
+     * @brief Exclusive use of one object of the pool, movable
+     */
+    class handle {
+    public:
+        handle() noexcept = default;
+        handle(handle const&) = delete;
+        handle& operator=(handle const&) = delete;
+
+        handle(handle&& other) noexcept 
+            : pool_(std::exchange(other.pool_, nullptr)), 
+              object_(std::exchange(other.object_, nullptr)) 
+        {}
+        handle& operator=(handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = std::exchange(other.pool_, nullptr);
+                object_ = std::exchange(other.object_, nullptr);
+            }
+            return *this;
+        }
+        ~handle() {
+            reset();
+        }
+
+        /// Returns the object to the pool, waking the task waiting longest for one
+        void reset() {
+            if (object_) {
+                std::exchange(pool_, nullptr)->release(*std::exchange(object_, nullptr));
+            }
+        }
+
+        value_type* get() const noexcept { return object_; }
+        value_type& operator*() const noexcept { return *object_; }
+        value_type* operator->() const noexcept { return object_; }
+        explicit operator bool() const noexcept { return object_ != nullptr; }
+
+    private:
+        friend pool_type;
+
+        handle(pool_type& p, value_type& o) noexcept : pool_(&p), object_(&o) {}
+
+        pool_type* pool_ = nullptr;
+        value_type* object_ = nullptr;
+    };
+
+    /**
+     * @brief Awaitable of a free object, yields an empty handle if woken without one
+     */
+    struct acquire_awaitable : public scheduler_friend<acquire_awaitable, S>, public etl::bidirectional_link<0> {
+    public:
+        using base_type = scheduler_friend<acquire_awaitable, S>;
+
+        acquire_awaitable(pool_type& p) noexcept : pool_(p) {}
+        ~acquire_awaitable() {
+            pool_.dequeue(*this);
+            if (object_) {
+                // Handed over to a task destroyed before it resumed, pass it on
+                pool_.release(*object_);
+            }
+        }
+
+        // Awaitable interface
+        bool await_ready() noexcept {
+            object_ = pool_.take();
+            return object_ != nullptr;
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            handle_ = h.promise().task_handle();
+            pool_.waiters_.push_back(*this);
+            return base_type::suspend_if_active(h);
+        }
+        handle await_resume() noexcept {
+            pool_.dequeue(*this);
+            handle_ = nullptr;
+            if (!object_) {
+                return handle{};
+            }
+            return handle(pool_, *std::exchange(object_, nullptr));
+        }
+
+    private:
+        friend pool_type;
+
+        void give(value_type& o) {
+            object_ = &o;
+            base_type::schedule_if_suspended(handle_);
+        }
+
+        pool_type& pool_;
+        value_type* object_ = nullptr;
+        async_task_handle_type handle_;
+    };
+
+    object_pool() noexcept(std::is_nothrow_default_constructible_v<value_type>) {
+        for (uint32_t i = 0; i < N; i++) {
+            free_[i] = static_cast<uint32_t>(N - 1 - i);
+        }
+    }
+    object_pool(object_pool const&) = delete;
+    object_pool& operator=(object_pool const&) = delete;
+
+    acquire_awaitable acquire() noexcept {
+        return acquire_awaitable(*this);
+    }
+    /// A free object without waiting, an empty handle if there is none
+    handle try_acquire() noexcept {
+        auto* o = take();
+        return o ? handle(*this, *o) : handle{};
     }
 
-    void run_one() {
-        schedule_all_suspended();
+    /// Objects not lent out
+    size_t available() const noexcept { return free_count_; }
+    static constexpr size_t capacity() noexcept { return N; }
 
-        for ( ; ; ) {
-            run_once();
+private:
+    value_type* take() noexcept {
+        if (free_count_ == 0) {
+            return nullptr;
+        }
+        return &objects_[free_[--free_count_]];
+    }
+    void release(value_type& o) {
+        if (!waiters_.empty()) {
+            auto& a = waiters_.front();
+            waiters_.pop_front();
+            a.clear();
+            a.give(o);
+            return;
+        }
+        free_[free_count_++] = static_cast<uint32_t>(&o - objects_);
+    }
+    void dequeue(acquire_awaitable& a) {
+        if (a.is_linked()) {
+            waiters_.erase(a);
+            a.clear();
         }
     }
-};
 
-template <typename T, typename S>
-concept Service = requires(T s) {
-    { s.run_once() } -> std::convertible_to<bool>;
+    value_type objects_[N];
+    uint32_t free_[N];               ///< Indices of the free objects, the most recently returned last
+    uint32_t free_count_ = N;
+    etl::intrusive_list<acquire_awaitable, etl::bidirectional_link<0>> waiters_;
 };
 
-template <typename H, typename S>
-concept Handle = requires(H& h) {
-    { h.promise().task_handle() } -> std::convertible_to<typename S::async_task_handle_type>;
-};
+/**
+ * @brief Part of task_group independent of its capacity, notified by the scheduler
+ */
+template <typename S>
+class task_group_base {
+public:
+    using scheduler_type = S;
+    using async_task_type = scheduler_type::async_task_type;
+    using async_task_handle_type = scheduler_type::async_task_handle_type;
+    using event_type = event<scheduler_type>;
+    using event_awaitable_type = event_type::event_awaitable_type;
 
-template <typename A, typename S>
-concept Awaitable = requires(A a, S::async_task_handle_type h) {
-    { a.await_ready() } -> std::convertible_to<bool>;
-    { a.await_suspend(h) };
-    { a.await_resume() };
-};
+    friend scheduler_type;
 
+    /**
+     * @brief Awaitable completing once no child of the group is running
+     */
+    struct join_awaitable {
+        join_awaitable(task_group_base& g) noexcept : group_(g), awaitable_(g.joined_.create_awaitable()) {}
 
-/**
- * @brief A friend class providing scheduling functionality for derived classes.
- * 
- * This class provides a common interface for scheduling and managing tasks within a scheduler system.
- * It ensures that derived classes are either Awaitable or Service compatible with the scheduler.
- * 
- * @tparam D The derived class type
- * @tparam S The scheduler type
- * 
- * @note The derived class must satisfy either Awaitable<D, S> or Service<D, S> concept
- */
-template <typename D, typename S>
-struct scheduler_friend {
-    using async_task_handle_type = S::async_task_handle_type;
+        // Awaitable interface
+        bool await_ready() noexcept {
+            return group_.running_ == 0;
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            return awaitable_.await_suspend(h);
+        }
+        void await_resume() {
+            awaitable_.await_resume();
+        }
 
-    scheduler_friend(scheduler_friend const& other) = delete;
-    scheduler_friend& operator=(scheduler_friend const& other) = delete;
-    scheduler_friend() : s_(S::get_instance()) { 
-        static_assert(Awaitable<D, S> || Service<D, S>, "derived class is not compatible");
+    private:
+        task_group_base& group_;
+        event_awaitable_type awaitable_;
+    };
+
+    task_group_base(task_group_base const&) = delete;
+    task_group_base& operator=(task_group_base const&) = delete;
+
+    join_awaitable join() noexcept {
+        return join_awaitable(*this);
     }
+    /// Children that have not completed yet
+    size_t running() const noexcept { return running_; }
 
 protected:
-    template <Handle<S> H>
-    bool schedule_if_active(H& h) { 
-        return s_.schedule(h, [](task_state state) { return state == task_state::ACTIVE; }); 
+    task_group_base() noexcept = default;
+    ~task_group_base() = default;
+
+    /// Takes over the task's frame and schedules it, the task object is left empty
+    async_task_handle_type adopt(async_task_type& task) {
+        auto h = std::exchange(task.handle_, nullptr);
+        h.promise().group_ = this;
+        running_++;
+        scheduler_type::instance().schedule(h, [](task_state state) { return state == task_state::SUSPENDED; });
+        return h;
     }
-    template <Handle<S> H>
-    bool schedule_if_suspended(H& h) { 
-        return s_.schedule(h, [](task_state state) { return state == task_state::SUSPENDED; }); 
+    /// Destroys a child's frame, returns whether it was still running
+    bool destroy(async_task_handle_type h) {
+        bool running = h.promise().state_ != task_state::DONE;
+        h.destroy();
+        if (running && --running_ == 0) {
+            joined_.activate();
+        }
+        return running;
     }
-    template <Handle<S> H>
-    bool suspend_if_active(H& h) { 
-        return s_.suspend(h, [](task_state state) {return state == task_state::ACTIVE; }); 
+    static bool finished(async_task_handle_type h) noexcept {
+        return h.promise().state_ == task_state::DONE;
     }
 
 private:
-    S& s_;
+    void child_done() {
+        if (--running_ == 0) {
+            joined_.activate();
+        }
+    }
+
+    uint32_t running_ = 0;
+    event_type joined_;
 };
 
 /**
- * @brief An awaitable that yields control back to the scheduler
- * 
- * This awaitable allows a coroutine to voluntarily give up its execution time
- * to allow other coroutines to run. When awaited, it suspends the current
- * task and reschedules it for later execution.
- * 
- * @tparam S The scheduler type this awaitable works with
+ * @brief Owner of up to N child tasks that can be joined or cancelled together
+ *
+ * spawn() takes a task over and starts it; co_await join() completes once every child
+ * has completed, woken by the scheduler as the last one finishes. cancel() destroys all
+ * children, running or not, as does destroying the group:
+ * @code
+ * async_task serve(listener& l) {
+ *     task_group<S, 4> connections;
+ *     while (auto c = co_await l.accept()) {
+ *         if (!connections.spawn(handle_connection(c))) {
+ *             co_await connections.join();
+ *             ...
+ *         }
+ *     }
+ *     co_await connections.join();
+ * }
+ * @endcode
+ *
+ * A completed child keeps its frame until its slot is taken by a later spawn(), or until
+ * cancel(). Children must not destroy or cancel their own group.
+ *
+ * @tparam S The scheduler type
+ * @tparam N Number of children, at most max_task_count
  */
-template <typename S>
-struct yield_awaitable : public scheduler_friend<yield_awaitable<S>, S> {
-public:
-    using async_task_handle_type = S::async_task_handle_type;
-    using base_type = scheduler_friend<yield_awaitable<S>, S>;
-
-    // Awaitable interface
-    bool await_ready() { return false; }
-    template <Handle<S> H>
-    bool await_suspend(H h) { return base_type::schedule_if_active(h); }
-    void await_resume()  {}
-};
-
-template <typename S>
-struct event_awaitable;
-
-template <typename S, typename Derived = void> 
-struct event {
+template <typename S, size_t N>
+class task_group : public task_group_base<S> {
 public:
-    using scheduler_type = S;
-    using event_type = event<S>;
-    using event_awaitable_type = event_awaitable<scheduler_type>;
-    using awaitable_list = etl::intrusive_forward_list<event_awaitable_type, etl::forward_link<0>>;
+    using base_type = task_group_base<S>;
+    using async_task_type = base_type::async_task_type;
+    using async_task_handle_type = base_type::async_task_handle_type;
 
-    friend event_awaitable_type;
+    static_assert(N != 0 && N <= S::config_type::max_task_count, "task group larger than the task registry");
 
-    static_assert(std::is_same_v<Derived, void> || std::derived_from<event<S, Derived>, Derived>, 
-        "Derived class must be derived from event");
+    task_group() noexcept = default;
+    ~task_group() {
+        cancel();
+    }
 
-    bool activate() { 
-        if (active_ || awaitables_.empty()) {
+    /**
+     * @brief Takes the task over and starts it
+     * @return false, leaving the task with the caller, if it is invalid or all N children
+     *         are still running
+     */
+    bool spawn(async_task_type&& task) {
+        if (task.state() != task_state::SUSPENDED) {
             return false;
         }
-
-        active_ = true; 
-        for (auto& awaitable: awaitables_) {
-            awaitable.notify();
+        for (auto& child: children_) {
+            if (child && base_type::finished(child)) {
+                base_type::destroy(std::exchange(child, nullptr));
+            }
+            if (!child) {
+                child = base_type::adopt(task);
+                return true;
+            }
         }
-        return true;
-    }
-    bool is_active() { 
-        return active_; 
-    }
-
-    auto create_awaitable(bool auto_activate = false) noexcept { return event_awaitable_type(*this, auto_activate); }
-    auto operator co_await() noexcept { return create_awaitable(); }
-
-protected:
-    void insert_awaitable(event_awaitable_type& a) {
-        awaitables_.push_front(a);
+        return false;
     }
-    void erase_awaitable(event_awaitable_type& a) {
-        awaitables_.erase(a);
-        if (awaitables_.empty()) {
-            active_ = false;
+    /// Destroys every child, returns how many were still running
+    size_t cancel() {
+        size_t cancelled = 0;
+        for (auto& child: children_) {
+            if (child) {
+                cancelled += base_type::destroy(std::exchange(child, nullptr));
+            }
         }
+        return cancelled;
     }
 
-    bool active_ = false;
-    awaitable_list awaitables_;
+    static constexpr size_t capacity() noexcept { return N; }
+
+private:
+    async_task_handle_type children_[N]{};
 };
 
-template <typename S>
-struct event_awaitable : public scheduler_friend<event_awaitable<S>, S>, public etl::forward_link<0> {
+/**
+ * @brief Task of a coroutine function that is run over and over, restarted in place
+ *
+ * restart(args...) calls F(args...) and starts the task. Once that run has completed,
+ * the next restart() builds the new coroutine in the frame of the finished one: nothing
+ * is allocated and the task keeps its registry entry and priority, so running a periodic
+ * job again costs about as much as resuming it:
+ * @code
+ * async_task filter_block(channel& ch) { ... }
+ *
+ * persistent_task<S, filter_block> filter;
+ *
+ * async_task sampler() {
+ *     for ( ; ; ) {
+ *         co_await timers.sleep_for(10ms);
+ *         filter.restart(adc0);
+ *     }
+ * }
+ * @endcode
+ *
+ * The frame is held from the first restart() until the persistent_task is destroyed.
+ *
+ * @tparam S The scheduler type
+ * @tparam F Coroutine function returning the scheduler's async_task_type
+ */
+template <typename S, auto F>
+class persistent_task {
 public:
     using scheduler_type = S;
-    using event_type = event<scheduler_type>;
+    using async_task_type = scheduler_type::async_task_type;
     using async_task_handle_type = scheduler_type::async_task_handle_type;
-    using base_type = scheduler_friend<event_awaitable<S>, S>;
 
-    event_awaitable(event_type& e, bool auto_activate = false) : event_(e) {
-        e.insert_awaitable(*this);
-        if (auto_activate) {
-            e.activate();
-        }
-    }
-    ~event_awaitable() { 
-        event_.erase_awaitable(*this);
-    }
+    persistent_task() noexcept = default;
+    persistent_task(persistent_task const&) = delete;
+    persistent_task& operator=(persistent_task const&) = delete;
 
-    bool notify() { 
-        if (!handle_) {
-            return false;
+    ~persistent_task() {
+        if (handle_) {
+            handle_.destroy();
         }
-        return base_type::schedule_if_suspended(handle_);
     }
 
-    // Awaitable interface 
-    bool await_ready() { 
-        return event_.is_active(); 
+    /**
+     * @brief Runs F(args...) from the beginning
+     * @return false if the previous run has not completed yet, or if the task registry
+     *         is full on the first run
+     */
+    template <typename... A>
+    bool restart(A&&... args) {
+        return scheduler_type::task_instance().restart_task(handle_, [&] { return F(std::forward<A>(args)...); });
     }
-    template <Handle<S> H>
-    bool await_suspend(H h) {
-        handle_ = h.promise().task_handle();
-        return base_type::suspend_if_active(h);
+
+    /// State of the current run, INACTIVE before the first one
+    task_state state() const noexcept {
+        return handle_ ? handle_.promise().state_ : task_state::INACTIVE;
     }
-    void await_resume() {
-        handle_ = nullptr;
+    /// Whether a run is under way, i.e. restart() would fail
+    bool running() const noexcept {
+        return handle_ && handle_.promise().state_ != task_state::DONE;
     }
 
 private:
-    event_type& event_;
-    async_task_handle_type handle_;
+    async_task_handle_type handle_{};
 };
 
 template <typename S, typename ...A>
 struct any_of_awaitable {
 public:
     direct_tuple<A...> awaitables_;
-    S& s{S::get_instance()};
 
     // Awaitable interface
     bool await_ready() { 
@@ -701,15 +3200,6 @@ public:
 };
 
 
-template <typename C>
-concept Clock = requires(C c, typename C::time_type t, typename C::duration_type d) {
-    { c.now() } -> std::convertible_to<typename C::time_type>;
-    { t + d } -> std::convertible_to<typename C::time_type>;
-    { t - d } -> std::convertible_to<typename C::time_type>;
-    { t <=> t } -> std::convertible_to<std::strong_ordering>;
-    { d <=> d } -> std::convertible_to<std::strong_ordering>;
-};
-
 template <Clock C, typename S>
 class timer_service : public scheduler_friend<timer_service<C, S>, S> {
 public:
@@ -720,17 +3210,66 @@ public:
     using base_type = scheduler_friend<timer_service_type, S>;
     using async_task_handle_type = S::async_task_handle_type;
 
+    using traits_type = scheduler_traits<S>;
+    using histogram_type = traits_type::histogram_type;
+
+    struct timer;
+
+    /// A timer's event stays active once the timer fired, however late it is awaited
+    using timer_event = latched_event<S>;
+
+    /**
+     * @brief Awaitable of a timer that also records how late the waiter resumed
+     * 
+     * Only used when wakeup_histograms is enabled; otherwise awaiting a timer yields a
+     * plain event_awaitable.
+     */
+    struct timer_awaitable {
+        using event_awaitable_type = timer_event::event_awaitable_type;
+
+        timer_awaitable(timer& t) noexcept 
+            : awaitable_(t.event_.create_awaitable()),
+              service_(t.expired() ? nullptr : t.service_.get()),
+              deadline_(t.time_)
+        {}
+
+        // Awaitable interface
+        bool await_ready() { 
+            return awaitable_.await_ready(); 
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            waited_ = true;
+            return awaitable_.await_suspend(h);
+        }
+        void await_resume() {
+            awaitable_.skip_wakeup_record();
+            awaitable_.await_resume();
+            if (waited_ && service_) {
+                service_->record_wakeup(deadline_);
+            }
+            waited_ = false;
+        }
+
+    private:
+        event_awaitable_type awaitable_;
+        timer_service_type* service_;
+        time_type deadline_;
+        bool waited_ = false;
+    };
+
     struct timer : etl::forward_link<0>{
         friend class timer_service<C, S>;
     public:
-        using event_awaitable_type = event_awaitable<S>;
+        using event_awaitable_type = timer_event::event_awaitable_type;
+        using awaitable_type = std::conditional_t<traits_type::wakeup_histograms, timer_awaitable, event_awaitable_type>;
 
         timer(timer_service& service, time_type const& time) noexcept 
             : service_(service), 
               time_(time), 
               event_() 
         {
-            pr_debug("timer created");
+            S::log("timer %p: created", this);
             service_->schedule_timer(*this);
         }
         timer(timer const& other) = delete;
@@ -738,7 +3277,7 @@ public:
 
         ~timer() 
         {
-            pr_debug("timer destroyed");
+            S::log("timer %p: destroyed", this);
             if (service_.is_valid()) {
                 service_->abort_timer(*this);
             }
@@ -750,26 +3289,32 @@ public:
         bool expired() const noexcept {
             return !service_.is_valid();
         }
-        event_awaitable_type operator co_await() noexcept {
-            if (expired()) { 
-                pr_debug("timer expired: reactivating event");
+        awaitable_type operator co_await() noexcept {
+            if (expired() && !event_.is_active()) { 
+                // Aborted without firing, complete the co_await anyway
+                S::log("timer %p: awaited after abort, activating event", this);
+                event_.activate();
+            }
+            if constexpr (traits_type::wakeup_histograms) {
+                return timer_awaitable(*this);
+            } else {
+                return event_.create_awaitable();
             }
-            return event_.create_awaitable(expired());
         }
 
     private:
         resetable_ref<timer_service_type> service_;
         time_type time_;
-        event<S> event_;
+        timer_event event_;
     };
 
 public:
     timer_service(clock_type& clock) noexcept : 
-        s_(S::get_instance()), 
         clock_(clock) 
     {}
 
     bool schedule_timer(timer& timer) noexcept {
+        S::trace(trace_event::timer_arm, &timer);
         auto time = timer.time_;
         auto it = timers_.begin(), it_prev = timers_.begin();
 
@@ -793,7 +3338,8 @@ public:
         if (timer.expired()) {
             return false;
         }
-        pr_debug("aborting timer");
+        S::log("timer %p: aborted", &timer);
+        S::trace(trace_event::timer_abort, &timer);
         timers_.erase(timer);
         timer.service_.reset();
         return true;
@@ -803,7 +3349,39 @@ public:
         return sleep_until(clock_.now() + dur);
     }
 
+    /// Current time of the service's clock
+    time_type now() noexcept {
+        return clock_.now();
+    }
+
+    /**
+     * @brief Clock ticks from each timer's deadline to the resume of the task waiting on it
+     * 
+     * A no_histogram stub unless wakeup_histograms is configured.
+     */
+    histogram_type& wakeup_latency() noexcept { 
+        return wakeups_; 
+    }
+
+    /**
+     * @brief Deadline of the timer due first
+     * 
+     * Lets the caller of a run loop that returned quiescent sleep until the next timer
+     * fires rather than poll; timers armed later, e.g. from an interrupt, move it closer.
+     * 
+     * @return false if no timer is armed, leaving time untouched
+     */
+    bool next_expiry(time_type& time) const noexcept {
+        if (timers_.empty()) return false;
+        time = timers_.front().time_;
+        return true;
+    }
+
     // Service interface
+    bool has_pending() const noexcept {
+        return !timers_.empty();
+    }
+
     bool run_once() {
         auto now = clock_.now();
 
@@ -811,6 +3389,7 @@ public:
 
         auto& timer = timers_.front();
         if (now >= timer.time_) {
+            S::trace(trace_event::timer_fire, &timer);
             timer.event_.activate();
             timer.service_.reset(); // This service is done with the timer
             timers_.pop_front();
@@ -822,15 +3401,212 @@ public:
     }
 
 private:
-    S& s_;
+    void record_wakeup(time_type const& deadline) {
+        auto now = clock_.now();
+        if (now >= deadline) {
+            wakeups_.record(detail::duration_ticks(now - deadline));
+        }
+    }
+
     clock_type& clock_;
     etl::intrusive_forward_list<timer, etl::forward_link<0>> timers_;
+    [[no_unique_address]] histogram_type wakeups_;
 
     static event<S> null_event;
 };
 template <Clock C, typename S>
 event<S> timer_service<C, S>::null_event{};
 
+/**
+ * @brief Token bucket shaping how often tasks may proceed
+ *
+ * Tokens refill at one per interval up to burst. co_await acquire(n) completes at once
+ * while n tokens are there and no task is waiting; otherwise the task suspends until its
+ * tokens have refilled. Waiters are released in the order they suspended:
+ * @code
+ * rate_limiter<clock, S> airtime{timers, 10ms, 4};
+ *
+ * async_task beacon() {
+ *     for ( ; ; ) {
+ *         co_await airtime.acquire();
+ *         radio.send(beacon_frame);
+ *     }
+ * }
+ * @endcode
+ *
+ * A task that has to wait reserves its tokens right away, which fixes the time it is
+ * released; the limiter keeps a single timer, armed for the waiter released first, so
+ * the timer service holds one timer however many tasks are throttled. A waiter destroyed
+ * before it was released has spent its tokens all the same. Asking for more tokens than
+ * burst only waits the longer.
+ *
+ * Needs duration_type multiplied by an integer. The limiter must outlive its waiters and
+ * the timer service must outlive the limiter.
+ *
+ * @tparam C Clock of the timer service
+ * @tparam S The scheduler type
+ */
+template <Clock C, typename S>
+class rate_limiter {
+public:
+    using scheduler_type = S;
+    using timer_service_type = timer_service<C, S>;
+    using time_type = timer_service_type::time_type;
+    using duration_type = timer_service_type::duration_type;
+    using limiter_type = rate_limiter<C, S>;
+    using async_task_handle_type = scheduler_type::async_task_handle_type;
+
+    /**
+     * @brief Awaitable of n tokens of a limiter
+     */
+    struct acquire_awaitable : public scheduler_friend<acquire_awaitable, S>, public etl::bidirectional_link<0> {
+    public:
+        using base_type = scheduler_friend<acquire_awaitable, S>;
+
+        acquire_awaitable(limiter_type& l, uint32_t n) noexcept : limiter_(l), tokens_(n) {}
+        ~acquire_awaitable() {
+            limiter_.leave(*this);
+        }
+
+        // Awaitable interface
+        bool await_ready() {
+            return limiter_.try_acquire(tokens_);
+        }
+        template <Handle<S> H>
+        bool await_suspend(H h) {
+            handle_ = h.promise().task_handle();
+            bool suspended = base_type::suspend_if_active(h);
+            limiter_.enqueue(*this);
+            return suspended;
+        }
+        void await_resume() {
+            limiter_.leave(*this);
+            handle_ = nullptr;
+        }
+
+    private:
+        friend limiter_type;
+
+        void release() {
+            base_type::schedule_if_suspended(handle_);
+        }
+
+        limiter_type& limiter_;
+        uint32_t tokens_;
+        time_type ready_at_{};     ///< When the reserved tokens are there
+        async_task_handle_type handle_;
+    };
+
+    /**
+     * @param interval Time to refill one token
+     * @param burst Tokens the bucket holds, all of them available from the start
+     */
+    rate_limiter(timer_service_type& service, duration_type interval, uint32_t burst) noexcept 
+        : service_(service), 
+          interval_(interval), 
+          window_(interval * burst), 
+          due_(service.now()) 
+    {}
+    rate_limiter(rate_limiter const&) = delete;
+    rate_limiter& operator=(rate_limiter const&) = delete;
+
+    ~rate_limiter() {
+        disarm();
+    }
+
+    acquire_awaitable acquire(uint32_t n = 1) noexcept {
+        return acquire_awaitable(*this, n);
+    }
+    /// Takes n tokens if they are there and no task is waiting, without suspending
+    bool try_acquire(uint32_t n = 1) {
+        if (!waiters_.empty()) {
+            return false;
+        }
+        auto now = service_.now();
+        auto due = (due_ < now ? now : due_) + interval_ * n;
+        if (now < due - window_) {
+            return false;
+        }
+        due_ = due;
+        return true;
+    }
+
+    /// Number of tasks waiting for tokens
+    size_t waiting() const noexcept { return waiters_.size(); }
+
+private:
+    using timer_type = timer_service_type::timer;
+    using wake_type = timer_type::awaitable_type;
+
+    /// Reserves the waiter's tokens, the head of the queue waits on the timer
+    void enqueue(acquire_awaitable& a) {
+        auto now = service_.now();
+        due_ = (due_ < now ? now : due_) + interval_ * a.tokens_;
+        a.ready_at_ = due_ - window_;
+        waiters_.push_back(a);
+        if (waiters_.size() == 1) {
+            arm(a);
+        }
+    }
+    void leave(acquire_awaitable& a) {
+        if (!a.is_linked()) {
+            return;
+        }
+        bool head = &waiters_.front() == &a;
+        waiters_.erase(a);
+        a.clear();
+        if (head) {
+            disarm();
+            release_due();
+        }
+    }
+    /// Releases the waiters whose tokens are there and arms the timer for the next one
+    void release_due() {
+        auto now = service_.now();
+        while (!waiters_.empty() && !(now < waiters_.front().ready_at_)) {
+            auto& a = waiters_.front();
+            waiters_.pop_front();
+            a.clear();
+            a.release();
+        }
+        if (!waiters_.empty()) {
+            arm(waiters_.front());
+        }
+    }
+
+    /*
+     * The head's task is already suspended when it gets here, so it is parked on the
+     * timer's event through an awaitable the limiter holds for it; the timer then
+     * schedules the task like any other waiter of a timer.
+     */
+    void arm(acquire_awaitable& a) {
+        new (&timer_) timer_type(service_, a.ready_at_);
+        new (&wake_) wake_type(timer_.operator co_await());
+        wake_.await_suspend(a.handle_);
+        armed_ = true;
+    }
+    void disarm() {
+        if (armed_) {
+            armed_ = false;
+            wake_.~wake_type();
+            timer_.~timer_type();
+        }
+    }
+
+    timer_service_type& service_;
+    duration_type interval_;
+    duration_type window_;         ///< interval times burst
+    time_type due_;                ///< When every token reserved so far has refilled
+    etl::intrusive_list<acquire_awaitable, etl::bidirectional_link<0>> waiters_;
+    union {
+        timer_type timer_;
+    };
+    union {
+        wake_type wake_;
+    };
+    bool armed_ = false;
+};
+
 
 }
 #endif
@@ -0,0 +1,139 @@
+#ifndef CORONIMO_TRACE_H_
+#define CORONIMO_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace adva::coronimo {
+
+/**
+ * @file trace.h
+ * @brief Fixed-size binary trace ring for scheduler timelines
+ *
+ * @details Recording claims a slot with a single relaxed fetch_add and fills it with
+ * a handful of stores, so it is cheap enough to stay enabled in production. When the
+ * ring wraps, the oldest records are overwritten.
+ *
+ * A ring is dumped with dump() into a self-describing binary blob (trace_dump_header
+ * followed by the records, oldest first), which tools/trace2chrome converts into
+ * Chrome-trace / Perfetto JSON on the host.
+ */
+
+enum class trace_event : uint8_t {
+    task_resume,     ///< subject: task frame
+    task_suspend,    ///< subject: task frame, arg: task_state after the slice
+    func_push,       ///< subject: async_func frame, arg: callstack depth after push
+    func_pop,        ///< subject: async_func frame, arg: callstack depth before pop
+    event_activate,  ///< subject: event
+    timer_arm,       ///< subject: timer
+    timer_fire,      ///< subject: timer
+    timer_abort,     ///< subject: timer
+};
+
+struct trace_record {
+    uint32_t timestamp;   ///< cycle_counter reading
+    trace_event kind;
+    uint8_t arg;
+    uint16_t reserved;
+    uintptr_t subject;    ///< Address of the object the event is about
+    uintptr_t task;       ///< Frame address of the task running at the time, 0 if none
+};
+
+struct trace_dump_header {
+    static constexpr uint32_t magic_value = 0x43525443; // "CTRC"
+    static constexpr uint16_t version_value = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t pointer_size;        ///< sizeof(uintptr_t) on the target
+    uint8_t record_size;         ///< sizeof(trace_record) on the target
+    uint32_t cycles_per_us;      ///< cycle_counter rate, 0 if unknown
+    uint32_t count;              ///< Number of records that follow
+    uint32_t lost;               ///< Records overwritten before the dump
+};
+
+/**
+ * @brief Lock-free ring of trace_records
+ *
+ * @tparam Counter CycleCounter providing timestamps
+ * @tparam N Capacity in records, must be a power of two
+ *
+ * Any number of writers (tasks, interrupt handlers) may record concurrently; a
+ * reader dumping while writers are active may observe a partially written record.
+ */
+template <typename Counter, size_t N>
+class trace_ring {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "trace ring size must be a power of two");
+
+public:
+    void record(trace_event kind, void const* subject, void const* task, uint8_t arg = 0) noexcept {
+        uint32_t i = head_.fetch_add(1, std::memory_order_relaxed);
+        auto& r = records_[i & (N - 1)];
+        r.timestamp = Counter::now();
+        r.kind = kind;
+        r.arg = arg;
+        r.subject = reinterpret_cast<uintptr_t>(subject);
+        r.task = reinterpret_cast<uintptr_t>(task);
+    }
+
+    /// Number of records currently held
+    size_t size() const noexcept {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        return head < N ? head : N;
+    }
+    static constexpr size_t capacity() noexcept { return N; }
+
+    void clear() noexcept {
+        head_.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes the ring as a trace_dump_header followed by its records, oldest first
+     *
+     * @param write Callable invoked as write(void const* data, size_t size), possibly
+     *              several times
+     * @param cycles_per_us Rate of the cycle counter stored in the header, 0 if unknown
+     */
+    template <typename W>
+    void dump(W&& write, uint32_t cycles_per_us = 0) const {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t count = head < N ? head : N;
+
+        trace_dump_header header{
+            trace_dump_header::magic_value,
+            trace_dump_header::version_value,
+            sizeof(uintptr_t),
+            sizeof(trace_record),
+            cycles_per_us,
+            count,
+            head - count,
+        };
+        write(static_cast<void const*>(&header), sizeof(header));
+
+        uint32_t first = head - count;
+        for (uint32_t i = 0; i < count; i++) {
+            write(static_cast<void const*>(&records_[(first + i) & (N - 1)]), sizeof(trace_record));
+        }
+    }
+
+private:
+    std::atomic<uint32_t> head_{0};
+    trace_record records_[N]{};
+};
+
+/**
+ * @brief Stand-in for trace_ring when tracing is disabled; every call compiles away
+ */
+struct no_trace {
+    void record(trace_event, void const*, void const*, uint8_t = 0) noexcept {}
+    size_t size() const noexcept { return 0; }
+    static constexpr size_t capacity() noexcept { return 0; }
+    void clear() noexcept {}
+    template <typename W>
+    void dump(W&&, uint32_t = 0) const {}
+};
+
+}
+
+#endif // CORONIMO_TRACE_H_
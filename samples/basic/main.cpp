@@ -186,8 +186,11 @@ int main()
     s.schedule_all_suspended();
 
     for ( ; ; ) {
-        s.run_once();
-        ts.run_once();
+        if (s.run_for(c, 100ms, cc::direct_tuple{ts}) == cc::run_result::quiescent) {
+            // Nothing runs before the next timer fires, sleep rather than spin
+            clock_std_chrono::time_type next;
+            std::this_thread::sleep_until(ts.next_expiry(next) ? next : c.now() + 100ms);
+        }
         //c.advance();
         //if (c.now() == 1000) e.activate();
         //std::this_thread::sleep_for(std::chrono::duration<double>(0.01));
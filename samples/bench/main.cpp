@@ -0,0 +1,627 @@
+#include <coronimo/scheduler.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <random>
+
+/*
+ * Scheduler microbenchmarks.
+ *
+ * Every result is printed as one JSON object per line on stdout:
+ *
+ *   {"bench":"yield","param":0,"iterations":1000000,"total_ns":...,"ns_per_op":...}
+ *
+ * "param" is the benchmark-specific size (waiter count, pending timer count)
+ * and is 0 where it does not apply. Pass a substring as the first argument
+ * to run only the matching benchmarks, e.g. `scheduler-bench timer`.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+/* Manually advanced clock, so timer benchmarks do not depend on wall time */
+struct clock_tick {
+    using time_type = long;
+    using duration_type = long;
+
+    time_type now() { return now_; }
+    void advance(duration_type d) { now_ += d; }
+private:
+    time_type now_ = 0;
+};
+
+static_assert(cc::Clock<clock_tick>, "This is no clock");
+
+struct bench_scheduler_config {
+    static constexpr size_t max_task_count = 1100;
+    static constexpr size_t timer_count = 16;
+};
+using bench_scheduler = cc::scheduler<bench_scheduler_config>;
+using yield = cc::yield_awaitable<bench_scheduler>;
+using maybe_yield = cc::maybe_yield_awaitable<bench_scheduler>;
+using event = cc::event<bench_scheduler>;
+using auto_reset_event = cc::auto_reset_event<bench_scheduler>;
+using timer_service = cc::timer_service<clock_tick, bench_scheduler>;
+using rate_limiter = cc::rate_limiter<clock_tick, bench_scheduler>;
+using job_group = cc::task_group<bench_scheduler, 64>;
+using async_task = bench_scheduler::async_task_type;
+using async_func = bench_scheduler::async_func_type;
+template <typename T> using async_generator = cc::async_generator<bench_scheduler, T>;
+template <typename T> using oneshot = cc::oneshot<T, bench_scheduler>;
+using sample_topic = cc::topic<size_t, 8, bench_scheduler>;
+using buffer_pool = cc::object_pool<size_t, 4, bench_scheduler>;
+template <typename ...A> struct app_any_of : cc::any_of_awaitable<bench_scheduler, A...> {};
+template <typename ...A> app_any_of(A&&...) -> app_any_of<A...>;
+
+using bench_clock = std::chrono::steady_clock;
+
+static char const* filter = nullptr;
+
+static bool enabled(char const* name) {
+    return filter == nullptr || std::strstr(name, filter) != nullptr;
+}
+
+static void report(char const* name, size_t param, size_t iterations, bench_clock::duration total) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(total).count();
+    std::printf("{\"bench\":\"%s\",\"param\":%zu,\"iterations\":%zu,\"total_ns\":%lld,\"ns_per_op\":%.3f}\n",
+        name, param, iterations, static_cast<long long>(ns), static_cast<double>(ns) / iterations);
+    std::fflush(stdout);
+}
+
+static void drain(bench_scheduler& s) {
+    while (s.run_once()) {}
+}
+
+/* Keeps the optimizer from discarding otherwise unobservable loops */
+static volatile size_t sink;
+
+async_func empty_func() {
+    co_return;
+}
+
+async_task empty_task() {
+    co_return;
+}
+
+async_task yield_task(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_await yield{};
+    }
+}
+
+async_task maybe_yield_task(size_t n, uint32_t budget) {
+    auto pace = maybe_yield::iterations(budget);
+    for (size_t i = 0; i < n; i++) {
+        co_await pace;
+    }
+}
+
+async_task call_task(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_await empty_func();
+    }
+}
+
+async_generator<size_t> count_generator(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_yield i;
+    }
+}
+
+async_task consume_task(size_t n) {
+    auto values = count_generator(n);
+    size_t sum = 0;
+    while (size_t* v = co_await values.next()) {
+        sum += *v;
+    }
+    sink = sum;
+}
+
+struct request {
+    size_t arg;
+    oneshot<size_t>::sender reply;
+};
+
+/* Answers every request put into the mailbox */
+async_task server_task(auto_reset_event& e, std::optional<request>& mailbox) {
+    for ( ; ; ) {
+        co_await e;
+        mailbox->reply.send(mailbox->arg + 1);
+        mailbox.reset();
+    }
+}
+
+async_task client_task(auto_reset_event& e, std::optional<request>& mailbox, size_t n) {
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        oneshot<size_t> reply;
+        mailbox.emplace(request{ i, reply.get_sender() });
+        e.activate();
+        if (size_t* v = co_await reply) {
+            sum += *v;
+        }
+    }
+    sink = sum;
+}
+
+/* Reads every message of the topic */
+async_task subscriber_task(sample_topic& t) {
+    sample_topic::subscriber sub{t};
+    size_t sum = 0;
+    for ( ; ; ) {
+        auto r = co_await sub.next();
+        if (r) {
+            sum += *r.message;
+        }
+        sink = sum;
+    }
+}
+
+/* Borrows a buffer from the pool for one slice, n times */
+async_task borrow_task(buffer_pool& pool, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        auto b = co_await pool.acquire();
+        *b = i;
+        co_await yield{};
+    }
+}
+
+/* Sends n times at the limiter's rate */
+async_task throttled_task(rate_limiter& limiter, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_await limiter.acquire();
+        sink = i;
+    }
+}
+
+/* Sends n times, sleeping its own share of the rate in between */
+async_task sleeping_task(timer_service& ts, long period, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_await ts.sleep_for(period);
+        sink = i;
+    }
+}
+
+/* Fans out jobs to a task group and joins them, n rounds */
+async_task fan_out_task(size_t jobs, size_t n) {
+    job_group group;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < jobs; j++) {
+            group.spawn(empty_task());
+        }
+        co_await group.join();
+    }
+}
+
+async_task wait_once_task(event& e) {
+    co_await e;
+    sink = sink + 1;
+}
+
+async_task wait_loop_task(event& e, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        co_await e;
+    }
+}
+
+/* Holds an awaitable of e it never awaits, while waiting for something else */
+async_task idle_holder_task(event& e, event& other) {
+    auto idle = e.create_awaitable();
+    co_await other;
+}
+
+/* Takes one queued item per wakeup */
+async_task worker_task(auto_reset_event& e, size_t& items) {
+    for ( ; ; ) {
+        co_await e;
+        if (items != 0) {
+            items--;
+        }
+    }
+}
+
+async_task any_of_loop_task(event& e1, event& e2, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        auto any = app_any_of{ e1.create_awaitable(), e2.create_awaitable() };
+        co_await any;
+    }
+}
+
+async_task ping_pong_task(event& mine, event& other, size_t n, bool handoff) {
+    for (size_t i = 0; i < n; i++) {
+        if (handoff) {
+            other.activate_handoff();
+        } else {
+            other.activate();
+        }
+        co_await mine;
+    }
+}
+
+static void bench_yield(bench_scheduler& s) {
+    constexpr size_t n = 1000000;
+    auto t = yield_task(n);
+    s.schedule_all_suspended();
+
+    auto start = bench_clock::now();
+    drain(s);
+    report("yield", 0, n, bench_clock::now() - start);
+}
+
+/* param: awaits per real yield */
+static void bench_maybe_yield(bench_scheduler& s) {
+    constexpr size_t n = 1000000;
+
+    for (uint32_t budget: { 1u, 16u, 256u }) {
+        auto t = maybe_yield_task(n, budget);
+        s.schedule_all_suspended();
+
+        auto start = bench_clock::now();
+        drain(s);
+        report("maybe_yield", budget, n, bench_clock::now() - start);
+    }
+}
+
+static void bench_async_func(bench_scheduler& s) {
+    constexpr size_t n = 1000000;
+    auto t = call_task(n);
+    s.schedule_all_suspended();
+
+    auto start = bench_clock::now();
+    drain(s);
+    report("async_func_call", 0, n, bench_clock::now() - start);
+}
+
+static void bench_generator(bench_scheduler& s) {
+    constexpr size_t n = 1000000;
+    auto t = consume_task(n);
+    s.schedule_all_suspended();
+
+    auto start = bench_clock::now();
+    drain(s);
+    report("generator_next", 0, n, bench_clock::now() - start);
+}
+
+static void bench_spawn(bench_scheduler& s) {
+    constexpr size_t n = 200000;
+
+    auto start = bench_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        auto t = empty_task();
+    }
+    report("task_spawn_destroy", 0, n, bench_clock::now() - start);
+
+    start = bench_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        auto t = empty_task();
+        s.schedule_all_suspended();
+        drain(s);
+    }
+    report("task_spawn_run_destroy", 0, n, bench_clock::now() - start);
+
+    start = bench_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        s.spawn_detached(empty_task());
+        drain(s);
+    }
+    report("task_spawn_detached", 0, n, bench_clock::now() - start);
+
+    cc::persistent_task<bench_scheduler, empty_task> persistent;
+    start = bench_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        persistent.restart();
+        drain(s);
+    }
+    report("task_restart_persistent", 0, n, bench_clock::now() - start);
+}
+
+static void bench_event_fanout(bench_scheduler& s) {
+    constexpr size_t rounds = 200;
+    event e{};
+
+    for (size_t waiters : { 1, 8, 64, 256, 1024 }) {
+        bench_clock::duration total{};
+        for (size_t r = 0; r < rounds; r++) {
+            auto tasks = std::make_unique<std::optional<async_task>[]>(waiters);
+            for (size_t i = 0; i < waiters; i++) {
+                tasks[i].emplace(wait_once_task(e));
+            }
+            // Let every waiter reach its co_await before timing
+            s.schedule_all_suspended();
+            drain(s);
+
+            auto start = bench_clock::now();
+            e.activate();
+            drain(s);
+            total += bench_clock::now() - start;
+        }
+        report("event_fanout", waiters, rounds * waiters, total);
+    }
+}
+
+/* Work items handed to a pool of workers one at a time, waking one each; param: worker count */
+static void bench_work_queue(bench_scheduler& s) {
+    constexpr size_t n = 200000;
+
+    for (size_t workers : { 1, 8, 64, 1024 }) {
+        auto_reset_event e{};
+        size_t items = 0;
+        auto tasks = std::make_unique<std::optional<async_task>[]>(workers);
+        for (size_t i = 0; i < workers; i++) {
+            tasks[i].emplace(worker_task(e, items));
+        }
+        s.schedule_all_suspended();
+        drain(s);
+
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            items++;
+            e.activate();
+            drain(s);
+        }
+        report("work_queue", workers, n, bench_clock::now() - start);
+    }
+}
+
+static void bench_timers(bench_scheduler& s) {
+    using timer = timer_service::timer;
+    constexpr size_t ops = 10000;
+    constexpr long horizon = 1000000;
+
+    for (size_t pending : { 10, 100, 1000, 10000 }) {
+        clock_tick c;
+        timer_service ts{c};
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<long> deadline(1, horizon);
+
+        auto armed = std::make_unique<std::optional<timer>[]>(pending);
+        for (size_t i = 0; i < pending; i++) {
+            armed[i].emplace(ts, deadline(gen));
+        }
+
+        auto probes = std::make_unique<std::optional<timer>[]>(ops);
+        auto times = std::make_unique<long[]>(ops);
+        for (size_t i = 0; i < ops; i++) {
+            times[i] = deadline(gen);
+        }
+
+        // Arm and cancel one timer at a time, so the pending count stays constant
+        bench_clock::duration arm{}, cancel{};
+        for (size_t i = 0; i < ops; i++) {
+            auto start = bench_clock::now();
+            probes[i].emplace(ts, times[i]);
+            auto mid = bench_clock::now();
+            probes[i].reset();
+            auto end = bench_clock::now();
+            arm += mid - start;
+            cancel += end - mid;
+        }
+        report("timer_arm", pending, ops, arm);
+        report("timer_cancel", pending, ops, cancel);
+
+        // Fire the earliest timer while the rest stay pending
+        bench_clock::duration fire{};
+        for (size_t i = 0; i < ops; i++) {
+            probes[i].emplace(ts, c.now());
+            auto start = bench_clock::now();
+            ts.run_once();
+            fire += bench_clock::now() - start;
+            probes[i].reset();
+        }
+        report("timer_fire", pending, ops, fire);
+    }
+}
+
+/* Two tasks waking each other with a few background tasks ready; param: 1 with handoff */
+static void bench_ping_pong(bench_scheduler& s) {
+    constexpr size_t n = 500000;
+
+    for (bool handoff: { false, true }) {
+        event ea{}, eb{};
+        auto b = ping_pong_task(eb, ea, n, handoff);
+        s.schedule_all_suspended();
+        s.run_once();
+
+        auto a = ping_pong_task(ea, eb, n, handoff);
+        auto bg1 = yield_task(n), bg2 = yield_task(n);
+        s.schedule_all_suspended();
+
+        auto start = bench_clock::now();
+        while (b.state() != cc::task_state::DONE) {
+            s.run_once();
+        }
+        report("event_ping_pong", handoff, n, bench_clock::now() - start);
+        drain(s);
+    }
+}
+
+/* One waiter woken while other tasks hold awaitables of the event they do not wait on; param: idle awaitables */
+static void bench_event_idle(bench_scheduler& s) {
+    constexpr size_t rounds = 2000;
+
+    for (size_t idle : { 0, 16, 256, 1024 }) {
+        bench_clock::duration total{};
+        for (size_t r = 0; r < rounds; r++) {
+            event e{}, other{};
+            auto holders = std::make_unique<std::optional<async_task>[]>(idle);
+            for (size_t i = 0; i < idle; i++) {
+                holders[i].emplace(idle_holder_task(e, other));
+            }
+            auto t = wait_once_task(e);
+            s.schedule_all_suspended();
+            drain(s);
+
+            auto start = bench_clock::now();
+            e.activate();
+            drain(s);
+            total += bench_clock::now() - start;
+        }
+        report("event_idle_awaitables", idle, rounds, total);
+    }
+}
+
+/* Request to a server task answered through a oneshot, one round trip per iteration */
+static void bench_oneshot(bench_scheduler& s) {
+    constexpr size_t n = 500000;
+    auto_reset_event e{};
+    std::optional<request> mailbox;
+
+    auto server = server_task(e, mailbox);
+    s.schedule_all_suspended();
+    drain(s);
+
+    auto client = client_task(e, mailbox, n);
+    s.schedule_all_suspended();
+
+    auto start = bench_clock::now();
+    drain(s);
+    report("oneshot_request", 0, n, bench_clock::now() - start);
+}
+
+/* Messages published to a topic, each read in place by every subscriber; param: subscriber count */
+static void bench_topic(bench_scheduler& s) {
+    constexpr size_t n = 100000;
+
+    for (size_t subscribers : { 1, 8, 64 }) {
+        sample_topic t;
+        auto tasks = std::make_unique<std::optional<async_task>[]>(subscribers);
+        for (size_t i = 0; i < subscribers; i++) {
+            tasks[i].emplace(subscriber_task(t));
+        }
+        s.schedule_all_suspended();
+        drain(s);
+
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            t.publish(i);
+            drain(s);
+        }
+        report("topic_broadcast", subscribers, n, bench_clock::now() - start);
+    }
+}
+
+/* Tasks taking turns on a pool of 4 buffers, waiting when all are lent out; param: task count */
+static void bench_object_pool(bench_scheduler& s) {
+    constexpr size_t n = 200000;
+
+    for (size_t tasks : { 1, 4, 16, 256 }) {
+        buffer_pool pool;
+        auto borrowers = std::make_unique<std::optional<async_task>[]>(tasks);
+        for (size_t i = 0; i < tasks; i++) {
+            borrowers[i].emplace(borrow_task(pool, n / tasks));
+        }
+        s.schedule_all_suspended();
+
+        auto start = bench_clock::now();
+        drain(s);
+        report("pool_acquire", tasks, n / tasks * tasks, bench_clock::now() - start);
+    }
+}
+
+/*
+ * Tasks throttled to one send per tick in total, through one rate_limiter or each with
+ * its own timer; param: task count
+ */
+static void bench_rate_limiter(bench_scheduler& s) {
+    constexpr size_t n = 100000;
+
+    for (size_t tasks : { 1, 16, 256 }) {
+        for (bool shared : { true, false }) {
+            clock_tick c;
+            timer_service ts{c};
+            rate_limiter limiter{ts, 1, 1};
+            auto senders = std::make_unique<std::optional<async_task>[]>(tasks);
+            for (size_t i = 0; i < tasks; i++) {
+                if (shared) {
+                    senders[i].emplace(throttled_task(limiter, n / tasks));
+                } else {
+                    senders[i].emplace(sleeping_task(ts, static_cast<long>(tasks), n / tasks));
+                }
+            }
+            s.schedule_all_suspended();
+            drain(s);
+
+            auto start = bench_clock::now();
+            for (size_t i = 0; i < n; i++) {
+                c.advance(1);
+                while (ts.run_once()) {}
+                drain(s);
+            }
+            report(shared ? "rate_limiter" : "rate_sleep_for", tasks, n / tasks * tasks, bench_clock::now() - start);
+        }
+    }
+}
+
+/* Rounds of spawning jobs into a group and joining them; param: jobs per round */
+static void bench_task_group(bench_scheduler& s) {
+    constexpr size_t n = 200000;
+
+    for (size_t jobs : { 1, 8, 64 }) {
+        auto t = fan_out_task(jobs, n / jobs);
+        s.start(t);
+
+        auto start = bench_clock::now();
+        drain(s);
+        report("task_group_join", jobs, n / jobs * jobs, bench_clock::now() - start);
+    }
+}
+
+static void bench_any_of(bench_scheduler& s) {
+    constexpr size_t n = 200000;
+    event e1{}, e2{};
+
+    {
+        auto t = wait_loop_task(e1, n);
+        s.schedule_all_suspended();
+        drain(s);
+
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            e1.activate();
+            drain(s);
+        }
+        report("event_wait", 0, n, bench_clock::now() - start);
+    }
+    {
+        auto t = any_of_loop_task(e1, e2, n);
+        s.schedule_all_suspended();
+        drain(s);
+
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            e1.activate();
+            drain(s);
+        }
+        report("any_of2_wait", 0, n, bench_clock::now() - start);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        filter = argv[1];
+    }
+
+    auto& s = bench_scheduler::get_instance();
+
+    if (enabled("yield")) bench_yield(s);
+    if (enabled("maybe_yield")) bench_maybe_yield(s);
+    if (enabled("async_func")) bench_async_func(s);
+    if (enabled("generator")) bench_generator(s);
+    if (enabled("spawn")) bench_spawn(s);
+    if (enabled("event_fanout")) bench_event_fanout(s);
+    if (enabled("work_queue")) bench_work_queue(s);
+    if (enabled("timer")) bench_timers(s);
+    if (enabled("any_of")) bench_any_of(s);
+    if (enabled("event_idle")) bench_event_idle(s);
+    if (enabled("ping_pong")) bench_ping_pong(s);
+    if (enabled("oneshot")) bench_oneshot(s);
+    if (enabled("topic")) bench_topic(s);
+    if (enabled("pool")) bench_object_pool(s);
+    if (enabled("rate")) bench_rate_limiter(s);
+    if (enabled("task_group")) bench_task_group(s);
+
+    return 0;
+}
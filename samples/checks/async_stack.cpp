@@ -0,0 +1,128 @@
+#include <coronimo/scheduler.h>
+#include <cstring>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Async stack walk: for_each_async_stack() visiting a task suspended in nested
+ * async_funcs innermost frame first, each frame with the co_await it is suspended
+ * at as recorded with await_locations, and following the task as it returns.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct stack_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool await_locations = true;
+};
+using stack_scheduler = cc::scheduler<stack_config>;
+using async_task = stack_scheduler::async_task_type;
+using async_func = stack_scheduler::async_func_type;
+using event = cc::event<stack_scheduler>;
+
+/* Lines of the co_awaits below */
+struct {
+    uint32_t inner, outer, outer_later, task;
+} await_line;
+
+async_func inner(event& e) {
+    await_line.inner = __LINE__ + 1;
+    co_await e;
+}
+
+async_func outer(event& e, event& f) {
+    await_line.outer = __LINE__ + 1;
+    co_await inner(e);
+    await_line.outer_later = __LINE__ + 1;
+    co_await f;
+}
+
+async_task nested(event& e, event& f) {
+    await_line.task = __LINE__ + 1;
+    co_await outer(e, f);
+}
+
+async_task flat(event& e) {
+    co_await e;
+}
+
+struct frame_row {
+    void* task;
+    size_t level;
+    void* address;
+    uint32_t line;
+    char const* function;
+    char const* file;
+};
+
+std::vector<frame_row> walk(stack_scheduler& s, void* task) {
+    std::vector<frame_row> rows;
+    s.for_each_async_stack([&](void* t, cc::task_state, size_t level, auto const& frame) {
+        if (t != task) return;
+        rows.push_back({t, level, frame.address, frame.location.line(),
+            frame.location.function_name(), frame.location.file_name()});
+    });
+    return rows;
+}
+
+bool in(char const* text, char const* part) {
+    return std::strstr(text, part) != nullptr;
+}
+
+void nested_frames(stack_scheduler& s) {
+    event e, f, g;
+    async_task t = nested(e, f);
+    void* task = s.snapshot()[0].address;
+    async_task u = flat(g);
+    CHECK(s.start(t) && s.start(u));
+    while (s.run_once()) {}
+
+    // Innermost first, the task frame last, each at its own co_await
+    auto rows = walk(s, task);
+    CHECK(rows.size() == 3);
+    for (size_t i = 0; i < rows.size(); i++) {
+        CHECK(rows[i].level == i);
+        CHECK(in(rows[i].file, "async_stack.cpp"));
+    }
+    CHECK(rows[0].line == await_line.inner && in(rows[0].function, "inner"));
+    CHECK(rows[1].line == await_line.outer && in(rows[1].function, "outer"));
+    CHECK(rows[2].line == await_line.task && in(rows[2].function, "nested"));
+    CHECK(rows[2].address == task);
+    CHECK(rows[0].address != rows[1].address && rows[0].address != task && rows[1].address != task);
+    void* outer_frame = rows[1].address;
+
+    // A task waiting outside of any async_func has its own frame only
+    void* other = nullptr;
+    for (auto& row: s.snapshot()) {
+        if (row.address != task) other = row.address;
+    }
+    auto flat_rows = walk(s, other);
+    CHECK(flat_rows.size() == 1 && flat_rows[0].address == other && in(flat_rows[0].function, "flat"));
+
+    // Back in outer, waiting at its second co_await
+    e.activate();
+    while (s.run_once()) {}
+    rows = walk(s, task);
+    CHECK(rows.size() == 2);
+    CHECK(rows[0].address == outer_frame && rows[0].line == await_line.outer_later);
+    CHECK(rows[1].address == task && rows[1].line == await_line.task);
+
+    // Completed, the task frame keeps its last co_await
+    f.activate();
+    g.activate();
+    while (s.run_once()) {}
+    CHECK(t.state() == cc::task_state::DONE);
+    rows = walk(s, task);
+    CHECK(rows.size() == 1 && rows[0].line == await_line.task);
+}
+
+}
+
+void check_async_stack() {
+    auto& s = stack_scheduler::get_instance();
+    nested_frames(s);
+}
@@ -0,0 +1,70 @@
+#ifndef CORONIMO_SAMPLES_CHECKS_H_
+#define CORONIMO_SAMPLES_CHECKS_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*
+ * Deterministic feature checks.
+ *
+ * Each feature is checked in its own translation unit with its own scheduler
+ * configuration; the configurations live in anonymous namespaces so every unit
+ * gets a distinct scheduler type and instance. A failed CHECK reports where it
+ * failed and exits with EXIT_FAILURE.
+ */
+
+[[noreturn]] inline void check_failed(char const* what, char const* file, int line) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    std::exit(EXIT_FAILURE);
+}
+
+#define CHECK(cond) ((cond) ? void(0) : check_failed(#cond, __FILE__, __LINE__))
+
+/* Ticks only when told to, so every deadline and timer is hit exactly */
+struct check_clock {
+    using time_type = long;
+    using duration_type = long;
+
+    time_type now() { return now_; }
+    void advance(duration_type d) { now_ += d; }
+    void set(time_type t) { now_ = t; }
+private:
+    time_type now_ = 0;
+};
+
+/* Cycle counter advanced by hand, standing in for the work a slice does */
+struct check_cycles {
+    static uint32_t now() { return now_; }
+    static void advance(uint32_t n) { now_ += n; }
+    static void set(uint32_t t) { now_ = t; }
+private:
+    static inline uint32_t now_ = 0;
+};
+
+/* Writes a dump into the directory given on the command line, if any */
+void write_dump(char const* name, std::vector<uint8_t> const& data);
+
+void check_task_stats();
+void check_trace();
+void check_histogram();
+void check_watchdog();
+void check_async_stack();
+void check_log();
+void check_run_loop();
+void check_maybe_yield();
+void check_handoff();
+void check_generator();
+void check_edf();
+void check_priority();
+void check_events();
+void check_oneshot();
+void check_topic();
+void check_pool();
+void check_rate_limiter();
+void check_task_group();
+void check_detached();
+void check_persistent();
+
+#endif
@@ -0,0 +1,84 @@
+#include <coronimo/scheduler.h>
+#include "checks.h"
+
+/*
+ * spawn_detached: the scheduler frees a detached task's registry entry and frame
+ * within the run_once() in which it completes, and never before.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct detached_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool frame_stats = true;
+};
+using detached_scheduler = cc::scheduler<detached_config>;
+using async_task = detached_scheduler::async_task_type;
+using event = cc::event<detached_scheduler>;
+
+int finished = 0;
+
+async_task job(event& e) {
+    co_await e;
+    finished++;
+}
+
+size_t live_frames() {
+    return detached_scheduler::frame_statistics().totals().live_frames;
+}
+
+void freed_on_completion(detached_scheduler& s) {
+    event e;
+    finished = 0;
+
+    for (size_t i = 0; i < detached_config::max_task_count; i++) {
+        CHECK(s.spawn_detached(job(e)));
+    }
+    while (s.run_once()) {}
+    CHECK(s.snapshot().size() == detached_config::max_task_count);
+    CHECK(live_frames() == detached_config::max_task_count);
+
+    // Suspended, the detached tasks keep their entries and the registry is full
+    CHECK(job(e).invalid());
+
+    // Each run_once() that completes a task frees its entry and frame right away
+    e.activate();
+    for (size_t i = 1; i <= detached_config::max_task_count; i++) {
+        CHECK(s.run_once());
+        CHECK(finished == int(i));
+        CHECK(s.snapshot().size() == detached_config::max_task_count - i);
+        CHECK(live_frames() == detached_config::max_task_count - i);
+        CHECK(s.check_invariants());
+    }
+    CHECK(!s.run_once());
+
+    // The freed entries take new tasks
+    async_task t = job(e);
+    CHECK(!t.invalid());
+}
+
+void refused_when_started(detached_scheduler& s) {
+    event e;
+    async_task t = job(e);
+    CHECK(s.start(t));
+    CHECK(!s.spawn_detached(std::move(t)));
+    CHECK(!t.invalid() && t.state() == cc::task_state::SCHEDULED);
+    while (s.run_once()) {}
+    e.activate();
+    while (s.run_once()) {}
+    CHECK(t.state() == cc::task_state::DONE);
+    CHECK(live_frames() == 1);
+}
+
+}
+
+void check_detached() {
+    auto& s = detached_scheduler::get_instance();
+    freed_on_completion(s);
+    refused_when_started(s);
+    CHECK(live_frames() == 0);
+}
@@ -0,0 +1,145 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Earliest-deadline-first ready queue: dispatch order, requeueing on a deadline
+ * change, first come first served among equal deadlines, and missed-deadline
+ * accounting per task and per scheduler.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct edf_config {
+    static constexpr size_t max_task_count = 16;
+    static constexpr size_t timer_count = 4;
+    using deadline_clock = check_clock;
+};
+using edf_scheduler = cc::scheduler<edf_config>;
+using yield = cc::yield_awaitable<edf_scheduler>;
+using event = cc::event<edf_scheduler>;
+using async_task = edf_scheduler::async_task_type;
+
+std::vector<int> ran;
+
+async_task job(int id) {
+    ran.push_back(id);
+    co_return;
+}
+
+async_task waiter(event& e, int rounds) {
+    for (int i = 0; i < rounds; i++) {
+        co_await e;
+    }
+}
+
+void run_all(edf_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+void earliest_first(edf_scheduler& s) {
+    ran.clear();
+    async_task none = job(0), late = job(1), early = job(2), mid = job(3);
+    s.set_deadline(late, 300);
+    s.set_deadline(early, 100);
+    s.set_deadline(mid, 200);
+    for (auto* t: {&none, &late, &early, &mid}) CHECK(s.start(*t));
+    run_all(s);
+    CHECK((ran == std::vector<int>{2, 3, 1, 0}));
+}
+
+void update_queued(edf_scheduler& s) {
+    ran.clear();
+    async_task a = job(1), b = job(2), c = job(3), d = job(4);
+    s.set_deadline(a, 100);
+    s.set_deadline(b, 200);
+    s.set_deadline(c, 300);
+    for (auto* t: {&a, &b, &c, &d}) CHECK(s.start(*t));
+
+    // All four are queued: move the last one to the front and the first one back
+    CHECK(s.set_deadline(c, 50));
+    CHECK(s.check_invariants());
+    CHECK(s.set_deadline(a, 250));
+    CHECK(s.check_invariants());
+    CHECK(s.clear_deadline(b));
+    CHECK(s.set_deadline(d, 150));
+    run_all(s);
+    CHECK((ran == std::vector<int>{3, 4, 1, 2}));
+}
+
+void equal_deadlines_fifo(edf_scheduler& s) {
+    ran.clear();
+    async_task t[6] = {job(0), job(1), job(2), job(3), job(4), job(5)};
+    for (int i: {4, 1, 5, 0, 3, 2}) {
+        s.set_deadline(t[i], 100);
+        CHECK(s.start(t[i]));
+    }
+    run_all(s);
+    CHECK((ran == std::vector<int>{4, 1, 5, 0, 3, 2}));
+
+    // Changing a queued task's deadline to an equal one keeps its place
+    ran.clear();
+    async_task u[3] = {job(0), job(1), job(2)};
+    for (auto& x: u) {
+        s.set_deadline(x, 100);
+        CHECK(s.start(x));
+    }
+    CHECK(s.set_deadline(u[0], 100));
+    run_all(s);
+    CHECK((ran == std::vector<int>{0, 1, 2}));
+}
+
+void deadline_misses(edf_scheduler& s, check_clock& clock) {
+    auto base = s.deadline_misses();
+    event e;
+    async_task late = waiter(e, 5), in_time = waiter(e, 5);
+    clock.set(0);
+    s.set_deadline(late, 5);
+    s.set_deadline(in_time, 100);
+    CHECK(s.start(late) && s.start(in_time));
+    run_all(s);
+    CHECK(late.deadline_misses() == 0 && in_time.deadline_misses() == 0);
+
+    clock.set(10);
+    e.activate();
+    run_all(s);
+    CHECK(late.deadline_misses() == 1);
+    CHECK(in_time.deadline_misses() == 0);
+    CHECK(s.deadline_misses() == base + 1);
+
+    // A passed deadline counts once however often the task runs after it
+    e.activate();
+    run_all(s);
+    CHECK(late.deadline_misses() == 1);
+    CHECK(s.deadline_misses() == base + 1);
+
+    // A new deadline can be missed again
+    s.set_deadline(late, 20);
+    e.activate();
+    run_all(s);
+    CHECK(late.deadline_misses() == 1);
+    clock.set(150);
+    e.activate();
+    run_all(s);
+    CHECK(late.deadline_misses() == 2);
+    CHECK(in_time.deadline_misses() == 1);
+    CHECK(s.deadline_misses() == base + 3);
+}
+
+}
+
+void check_edf() {
+    auto& s = edf_scheduler::get_instance();
+    static check_clock clock;
+    s.set_deadline_clock(clock);
+
+    earliest_first(s);
+    update_queued(s);
+    equal_deadlines_fifo(s);
+    deadline_misses(s, clock);
+}
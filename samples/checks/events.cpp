@@ -0,0 +1,231 @@
+#include <coronimo/scheduler.h>
+#include "checks.h"
+
+/*
+ * Event variants: the plain event's activation seen once by every awaitable that
+ * existed before it, and an any_of_awaitable leaving no arm parked once it resumed;
+ * counting_event buffering a bounded number of activations and waking one task per
+ * activation, latched_event staying active until reset().
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct events_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+};
+using events_scheduler = cc::scheduler<events_config>;
+using async_task = events_scheduler::async_task_type;
+using counting_event = cc::counting_event<events_scheduler, 3>;
+using latched_event = cc::latched_event<events_scheduler>;
+using event = cc::event<events_scheduler>;
+
+template <typename ...A> struct any_of : cc::any_of_awaitable<events_scheduler, A...> {};
+template <typename ...A> any_of(A&&...) -> any_of<A...>;
+
+template <typename E>
+async_task consumer(E& e, int& got, int n) {
+    for (int i = 0; i < n; i++) {
+        co_await e;
+        got++;
+    }
+}
+
+void run_all(events_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+/* Creates its awaitable, then waits for go before awaiting it twice */
+async_task early_awaiter(event& e, event& go, int& step) {
+    auto a = e.create_awaitable();
+    co_await go;
+    step = 1;
+    co_await a;
+    step = 2;
+    co_await a;
+    step = 3;
+}
+
+/* Waits for either event, then for f */
+async_task either(event& e1, event& e2, event& f, int& step) {
+    auto a1 = e1.create_awaitable();
+    auto a2 = e2.create_awaitable();
+    auto any = any_of{a1, a2};
+    co_await any;
+    step = 1;
+    co_await f;
+    step = 2;
+}
+
+/* Waits for either event, then on the arm that lost */
+async_task loser_again(event& e1, event& e2, int& step) {
+    auto a1 = e1.create_awaitable();
+    auto a2 = e2.create_awaitable();
+    auto any = any_of{a1, a2};
+    co_await any;
+    step = 1;
+    co_await a2;
+    step = 2;
+}
+
+void plain_seen_once(events_scheduler& s) {
+    event e, go;
+    int step[2] = {};
+    async_task t[2] = {early_awaiter(e, go, step[0]), early_awaiter(e, go, step[1])};
+    for (auto& x: t) CHECK(s.start(x));
+    run_all(s);
+
+    // Nobody is suspended on e, so activate() wakes no one, yet both awaitables see it
+    CHECK(!e.activate());
+    CHECK(e.is_active());
+    CHECK(go.activate());
+
+    // Each awaitable completes its first co_await at once and suspends on the second
+    run_all(s);
+    CHECK(step[0] == 2 && step[1] == 2);
+    for (auto& x: t) CHECK(x.state() == cc::task_state::SUSPENDED);
+    CHECK(!e.is_active());
+
+    // Now both are suspended on e, one activation wakes both
+    CHECK(e.activate());
+    run_all(s);
+    CHECK(step[0] == 3 && step[1] == 3);
+    CHECK(!e.activate());
+}
+
+void any_of_unparks(events_scheduler& s) {
+    event e1, e2, f;
+    int step = 0;
+    async_task t = either(e1, e2, f, step);
+    CHECK(s.start(t));
+    run_all(s);
+    CHECK(step == 0);
+
+    // The first arm wins, the task moves on to f
+    CHECK(e1.activate());
+    run_all(s);
+    CHECK(step == 1 && t.state() == cc::task_state::SUSPENDED);
+
+    // The losing arm is no longer parked, so e2 neither wakes nor reschedules the task
+    CHECK(!e2.activate());
+    CHECK(t.state() == cc::task_state::SUSPENDED);
+    run_all(s);
+    CHECK(step == 1);
+
+    CHECK(f.activate());
+    run_all(s);
+    CHECK(step == 2 && t.state() == cc::task_state::DONE);
+    CHECK(!e1.activate() && !e2.activate());
+
+    // The losing arm can be awaited on its own, it parks once and is woken once
+    step = 0;
+    async_task u = loser_again(e1, e2, step);
+    CHECK(s.start(u));
+    run_all(s);
+    CHECK(e1.activate());
+    run_all(s);
+    CHECK(step == 1 && u.state() == cc::task_state::SUSPENDED);
+    CHECK(e2.activate());
+    run_all(s);
+    CHECK(step == 2 && u.state() == cc::task_state::DONE);
+    CHECK(!e2.activate());
+}
+
+void counting_buffers(events_scheduler& s) {
+    counting_event e;
+
+    // Up to N activations are kept while nobody waits, the next one is dropped
+    CHECK(e.activate() && e.activate() && e.activate());
+    CHECK(!e.activate());
+    CHECK(e.count() == 3 && e.is_active());
+
+    int got = 0;
+    async_task t = consumer(e, got, 10);
+    CHECK(s.start(t));
+    run_all(s);
+    CHECK(got == 3);
+    CHECK(e.count() == 0 && !e.is_active());
+
+    // A waiting task takes the activation, nothing is buffered
+    CHECK(e.activate());
+    CHECK(e.count() == 0);
+    run_all(s);
+    CHECK(got == 4);
+
+    // Activations made before the waiter gets back to its co_await are not lost
+    CHECK(e.activate());
+    CHECK(e.activate() && e.activate());
+    CHECK(e.count() == 2);
+    run_all(s);
+    CHECK(got == 7 && e.count() == 0);
+}
+
+void counting_wakes_one(events_scheduler& s) {
+    counting_event e;
+    int got[3] = {};
+    async_task t[3] = {consumer(e, got[0], 1), consumer(e, got[1], 1), consumer(e, got[2], 1)};
+    for (auto& x: t) CHECK(s.start(x));
+    run_all(s);
+
+    // One activation per waiter, the longest waiting first
+    CHECK(e.activate());
+    run_all(s);
+    CHECK(got[0] == 1 && got[1] == 0 && got[2] == 0);
+    CHECK(e.activate());
+    CHECK(e.activate());
+    run_all(s);
+    CHECK(got[1] == 1 && got[2] == 1);
+    CHECK(e.count() == 0);
+
+    // With every waiter gone, activations are buffered again until reset()
+    CHECK(e.activate() && e.activate());
+    CHECK(e.count() == 2);
+    e.reset();
+    CHECK(e.count() == 0 && !e.is_active());
+}
+
+void latched_stays_active(events_scheduler& s) {
+    latched_event e;
+    int got[2] = {};
+    async_task t[2] = {consumer(e, got[0], 3), consumer(e, got[1], 3)};
+    for (auto& x: t) CHECK(s.start(x));
+    run_all(s);
+    CHECK(got[0] == 0 && got[1] == 0);
+
+    // One activation wakes every waiter, and later co_awaits complete at once
+    CHECK(e.activate());
+    CHECK(!e.activate());
+    CHECK(e.is_active());
+    run_all(s);
+    CHECK(got[0] == 3 && got[1] == 3);
+    CHECK(e.is_active());
+
+    // Consumed by reset(), the event makes waiters suspend again
+    CHECK(e.reset());
+    CHECK(!e.reset());
+    CHECK(!e.is_active());
+    int later = 0;
+    async_task u = consumer(e, later, 1);
+    CHECK(s.start(u));
+    run_all(s);
+    CHECK(later == 0 && u.state() == cc::task_state::SUSPENDED);
+    CHECK(e.activate());
+    run_all(s);
+    CHECK(later == 1 && u.state() == cc::task_state::DONE);
+}
+
+}
+
+void check_events() {
+    auto& s = events_scheduler::get_instance();
+    plain_seen_once(s);
+    any_of_unparks(s);
+    counting_buffers(s);
+    counting_wakes_one(s);
+    latched_stays_active(s);
+}
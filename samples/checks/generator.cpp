@@ -0,0 +1,212 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include <string>
+#include <vector>
+#include "checks.h"
+
+/*
+ * async_generator: an empty producer, a producer suspending the consuming task on an
+ * event and a timer between yields, consumption from a nested async_func with the
+ * producer joining the task's async stack, and a generator destroyed mid-stream
+ * releasing its frame without resuming it.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct generator_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool frame_stats = true;
+    static constexpr size_t log_size = 64;
+};
+using generator_scheduler = cc::scheduler<generator_config>;
+using async_task = generator_scheduler::async_task_type;
+using async_func = generator_scheduler::async_func_type;
+using generator = cc::async_generator<generator_scheduler, int>;
+using event = cc::event<generator_scheduler>;
+using timer_service = cc::timer_service<check_clock, generator_scheduler>;
+
+void run_all(generator_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+uint32_t live_frames() {
+    return generator_scheduler::frame_statistics().totals().live_frames;
+}
+
+/* Frames the consumer's async stack holds, innermost first */
+size_t stack_depth(generator_scheduler& s, void* task) {
+    size_t depth = 0;
+    s.for_each_async_stack([&](void* t, cc::task_state, size_t, auto const&) {
+        if (t == task) depth++;
+    });
+    return depth;
+}
+
+void* only_task(generator_scheduler& s) {
+    auto table = s.snapshot();
+    CHECK(table.size() == 1);
+    return table[0].address;
+}
+
+std::vector<std::string> drain_log() {
+    std::vector<std::string> lines;
+    generator_scheduler::log_buffer().drain([&](uint32_t, char const* text, size_t) { lines.push_back(text); });
+    return lines;
+}
+
+bool logged(std::vector<std::string> const& lines, char const* prefix) {
+    for (auto& line: lines) {
+        if (line.rfind(prefix, 0) == 0) return true;
+    }
+    return false;
+}
+
+generator none() {
+    co_return;
+}
+
+generator waits_between(event& e, timer_service& ts) {
+    co_yield 1;
+    co_await e;
+    co_yield 2;
+    auto t = ts.sleep_for(10);
+    co_await t;
+    co_yield 3;
+}
+
+async_task consume(generator g, std::vector<int>& got, int& ends) {
+    while (int* v = co_await g.next()) {
+        got.push_back(*v);
+    }
+    ends++;
+    // Past the end next() completes at once
+    if (!co_await g.next() && g.done()) ends++;
+}
+
+async_func drain(generator& g, std::vector<int>& got) {
+    while (int* v = co_await g.next()) {
+        got.push_back(*v);
+    }
+}
+
+async_task consume_nested(generator g, std::vector<int>& got) {
+    co_await drain(g, got);
+}
+
+/* Notes its destruction */
+struct frame_marker {
+    bool& destroyed;
+    ~frame_marker() { destroyed = true; }
+};
+
+generator endless(bool& destroyed, int& resumed) {
+    frame_marker marker{destroyed};
+    for (int i = 0; ; i++) {
+        co_yield i;
+        resumed++;
+    }
+}
+
+async_task take_two(std::optional<generator>& g, std::vector<int>& got) {
+    got.push_back(*co_await g->next());
+    got.push_back(*co_await g->next());
+    g.reset();
+    got.push_back(-1);
+}
+
+void empty(generator_scheduler& s) {
+    drain_log();
+    std::vector<int> got;
+    int ends = 0;
+    async_task t = consume(none(), got, ends);
+    CHECK(s.start(t));
+    run_all(s);
+    CHECK(got.empty() && ends == 2 && t.state() == cc::task_state::DONE);
+
+    // The generator's frame is labelled as such
+    auto lines = drain_log();
+    CHECK(logged(lines, "async_generator: allocating "));
+    CHECK(logged(lines, "async_generator 0x"));
+    CHECK(!logged(lines, "async_func"));
+}
+
+void suspends_between_yields(generator_scheduler& s, check_clock& clock, timer_service& ts) {
+    event e;
+    std::vector<int> got;
+    int ends = 0;
+    async_task t = consume(waits_between(e, ts), got, ends);
+    void* task = only_task(s);
+    CHECK(s.start(t));
+
+    // The task waits on the event inside the producer, which sits on its async stack
+    run_all(s);
+    CHECK((got == std::vector<int>{1}));
+    CHECK(t.state() == cc::task_state::SUSPENDED && stack_depth(s, task) == 2);
+
+    CHECK(e.activate());
+    run_all(s);
+    CHECK((got == std::vector<int>{1, 2}));
+    CHECK(t.state() == cc::task_state::SUSPENDED && stack_depth(s, task) == 2);
+
+    clock.advance(10);
+    CHECK(ts.run_once());
+    run_all(s);
+    CHECK((got == std::vector<int>{1, 2, 3}) && ends == 2);
+    CHECK(t.state() == cc::task_state::DONE && stack_depth(s, task) == 1);
+}
+
+void consumed_nested(generator_scheduler& s, check_clock& clock, timer_service& ts) {
+    event e;
+    std::vector<int> got;
+    async_task t = consume_nested(waits_between(e, ts), got);
+    void* task = only_task(s);
+    CHECK(s.start(t));
+
+    // The producer above the async_func above the task
+    run_all(s);
+    CHECK((got == std::vector<int>{1}) && stack_depth(s, task) == 3);
+    CHECK(e.activate());
+    run_all(s);
+    CHECK((got == std::vector<int>{1, 2}) && stack_depth(s, task) == 3);
+
+    clock.advance(10);
+    CHECK(ts.run_once());
+    run_all(s);
+    CHECK((got == std::vector<int>{1, 2, 3}) && t.state() == cc::task_state::DONE);
+}
+
+void destroyed_mid_stream(generator_scheduler& s) {
+    uint32_t before = live_frames();
+    bool destroyed = false;
+    int resumed = 0;
+    std::vector<int> got;
+    std::optional<generator> g{endless(destroyed, resumed)};
+    async_task t = take_two(g, got);
+    CHECK(live_frames() == before + 2);
+    CHECK(s.start(t));
+    run_all(s);
+
+    // Destroyed while suspended at its second yield, the producer is never resumed past it
+    CHECK((got == std::vector<int>{0, 1, -1}) && t.state() == cc::task_state::DONE);
+    CHECK(!g && destroyed && resumed == 1);
+    CHECK(live_frames() == before + 1);
+}
+
+}
+
+void check_generator() {
+    auto& s = generator_scheduler::get_instance();
+    static check_clock clock;
+    static timer_service ts{clock};
+    empty(s);
+    suspends_between_yields(s, clock, ts);
+    consumed_nested(s, clock, ts);
+    destroyed_mid_stream(s);
+    CHECK(live_frames() == 0);
+}
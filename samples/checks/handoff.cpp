@@ -0,0 +1,165 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Handoffs: tasks woken by event::activate_handoff() running right after the
+ * activating task within the same run_once(), chains of them cut at handoff_limit
+ * with the rest going through the ready queue, a destroyed target dropping its
+ * pending handoff, and activations that wake several tasks or come from outside a
+ * task handing off to nobody.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct handoff_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+    static constexpr size_t handoff_limit = 2;
+};
+using handoff_scheduler = cc::scheduler<handoff_config>;
+
+struct strict_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+    static constexpr size_t handoff_limit = 0;
+};
+using strict_scheduler = cc::scheduler<strict_config>;
+
+/* Task ids in the order they ran, each with the run_once() it ran in */
+using run_log = std::vector<std::pair<int, int>>;
+int run = 0;
+
+template <typename S>
+void run_all(S& s) {
+    run = 0;
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+        run++;
+    }
+}
+
+/* Waits for its event, then wakes the next task in the chain, if any */
+template <typename S>
+typename S::async_task_type link(int id, cc::event<S>& e, cc::event<S>* next, run_log& log) {
+    co_await e;
+    log.push_back({id, run});
+    if (next) next->activate_handoff();
+}
+
+template <typename S>
+typename S::async_task_type kicker(int id, cc::event<S>& e, run_log& log) {
+    log.push_back({id, run});
+    e.activate_handoff();
+    co_return;
+}
+
+template <typename S>
+typename S::async_task_type bystander(int id, run_log& log) {
+    log.push_back({id, run});
+    co_return;
+}
+
+/*
+ * Five linked tasks 0 to 4 woken in a chain by kicker 10, with bystander 20 queued
+ * behind the kicker
+ */
+template <typename S>
+run_log chain(S& s) {
+    using async_task = typename S::async_task_type;
+    run_log log;
+    cc::event<S> e[5];
+    async_task links[5] = {
+        link<S>(0, e[0], &e[1], log), link<S>(1, e[1], &e[2], log), link<S>(2, e[2], &e[3], log),
+        link<S>(3, e[3], &e[4], log), link<S>(4, e[4], nullptr, log),
+    };
+    for (auto& t: links) CHECK(s.start(t));
+    run_all(s);
+    CHECK(log.empty());
+
+    async_task k = kicker<S>(10, e[0], log);
+    async_task b = bystander<S>(20, log);
+    CHECK(s.start(k) && s.start(b));
+    run_all(s);
+    for (auto& t: links) CHECK(t.state() == cc::task_state::DONE);
+    return log;
+}
+
+void chain_cut_at_limit(handoff_scheduler& s) {
+    // Two handoffs per run_once(), then the next link waits behind the bystander
+    auto log = chain(s);
+    CHECK((log == run_log{{10, 0}, {0, 0}, {1, 0}, {20, 1}, {2, 2}, {3, 2}, {4, 2}}));
+}
+
+void no_handoffs(strict_scheduler& s) {
+    // Every woken task goes through the queue
+    auto log = chain(s);
+    CHECK((log == run_log{{10, 0}, {20, 1}, {0, 2}, {1, 3}, {2, 4}, {3, 5}, {4, 6}}));
+}
+
+using async_task = handoff_scheduler::async_task_type;
+using event = cc::event<handoff_scheduler>;
+
+async_task destroys_target(event& e, std::optional<async_task>& target, run_log& log) {
+    log.push_back({10, run});
+    e.activate_handoff();
+    target.reset();
+    co_return;
+}
+
+void destroyed_target(handoff_scheduler& s) {
+    run_log log;
+    event e;
+    std::optional<async_task> target{link<handoff_scheduler>(0, e, nullptr, log)};
+    CHECK(s.start(*target));
+    run_all(s);
+
+    // The target is woken and handed off to, then destroyed before it runs
+    async_task t = destroys_target(e, target, log);
+    async_task b = bystander<handoff_scheduler>(20, log);
+    CHECK(s.start(t) && s.start(b));
+    run_all(s);
+    CHECK(!target);
+    CHECK((log == run_log{{10, 0}, {20, 1}}));
+}
+
+void several_woken(handoff_scheduler& s) {
+    run_log log;
+    event e, unused;
+    async_task w[2] = {link<handoff_scheduler>(0, e, nullptr, log), link<handoff_scheduler>(1, e, nullptr, log)};
+    for (auto& t: w) CHECK(s.start(t));
+    run_all(s);
+
+    // Waking two tasks hands off to neither
+    async_task k = kicker<handoff_scheduler>(10, e, log);
+    async_task b = bystander<handoff_scheduler>(20, log);
+    CHECK(s.start(k) && s.start(b));
+    run_all(s);
+    CHECK((log == run_log{{10, 0}, {20, 1}, {0, 2}, {1, 3}}));
+
+    // Outside of a task it is a plain activate()
+    log.clear();
+    async_task x = link<handoff_scheduler>(0, unused, nullptr, log);
+    async_task y = bystander<handoff_scheduler>(20, log);
+    CHECK(s.start(x));
+    run_all(s);
+    CHECK(s.start(y));
+    CHECK(unused.activate_handoff());
+    run_all(s);
+    CHECK((log == run_log{{20, 0}, {0, 1}}));
+}
+
+}
+
+void check_handoff() {
+    auto& s = handoff_scheduler::get_instance();
+    chain_cut_at_limit(s);
+    destroyed_target(s);
+    several_woken(s);
+    no_handoffs(strict_scheduler::get_instance());
+}
@@ -0,0 +1,149 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Wakeup histograms: the log-linear bucketing at every bucket boundary and at the
+ * top of the 32-bit range, and the latencies the scheduler records for event and
+ * timer waiters, fed through the hand-driven cycle counter and clock.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct histogram_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool wakeup_histograms = true;
+    using cycle_counter = check_cycles;
+};
+using histogram_scheduler = cc::scheduler<histogram_config>;
+using async_task = histogram_scheduler::async_task_type;
+using event = cc::event<histogram_scheduler>;
+using timer_service = cc::timer_service<check_clock, histogram_scheduler>;
+using histogram = cc::log_linear_histogram<>;
+
+struct bucket {
+    uint32_t lower, upper;
+    uint64_t count;
+    bool operator==(bucket const&) const = default;
+};
+
+template <typename H>
+std::vector<bucket> buckets(H const& h) {
+    std::vector<bucket> v;
+    h.for_each_bucket([&](uint32_t lower, uint32_t upper, uint64_t count) { v.push_back({lower, upper, count}); });
+    return v;
+}
+
+void bucket_bounds() {
+    // Exact below 2^(SubBits + 1), then 8 sub-buckets per power of two
+    for (uint32_t v = 0; v < 16; v++) {
+        CHECK(histogram::index_of(v) == v);
+        CHECK(histogram::lower_bound_of(v) == v && histogram::upper_bound_of(v) == v);
+    }
+    CHECK(histogram::index_of(16) == 16 && histogram::index_of(17) == 16 && histogram::index_of(18) == 17);
+    CHECK(histogram::index_of(31) == 23 && histogram::index_of(32) == 24 && histogram::index_of(35) == 24);
+    CHECK(histogram::index_of(36) == 25);
+    CHECK(histogram::lower_bound_of(24) == 32 && histogram::upper_bound_of(24) == 35);
+
+    // The buckets tile the range without gaps, each bound falling into its own bucket
+    for (size_t i = 1; i < histogram::bucket_count; i++) {
+        CHECK(histogram::lower_bound_of(i) == histogram::upper_bound_of(i - 1) + 1);
+        CHECK(histogram::index_of(histogram::lower_bound_of(i)) == i);
+        CHECK(histogram::index_of(histogram::upper_bound_of(i)) == i);
+    }
+
+    // The top bucket ends at UINT32_MAX, nothing lies past it
+    constexpr size_t top = histogram::bucket_count - 1;
+    CHECK(histogram::index_of(UINT32_MAX) == top);
+    CHECK(histogram::index_of(0xf0000000u) == top && histogram::index_of(0xefffffffu) == top - 1);
+    CHECK(histogram::lower_bound_of(top) == 0xf0000000u && histogram::upper_bound_of(top) == UINT32_MAX);
+
+    histogram h;
+    for (uint32_t v: {0u, 7u, 7u, 16u, 17u, 100u, UINT32_MAX}) h.record(v);
+    CHECK((buckets(h) == std::vector<bucket>{
+        {0, 0, 1}, {7, 7, 2}, {16, 17, 2}, {96, 103, 1}, {0xf0000000u, UINT32_MAX, 1}}));
+    CHECK(h.count() == 7 && h.min() == 0 && h.max() == UINT32_MAX);
+    CHECK(h.value_at_percentile(50) == 16 + 1);
+    CHECK(h.value_at_percentile(80) == 103);
+    CHECK(h.value_at_percentile(100) == UINT32_MAX);
+
+    h.reset();
+    CHECK(h.count() == 0 && h.min() == 0 && h.max() == 0 && buckets(h).empty());
+    CHECK(h.value_at_percentile(99) == 0);
+}
+
+async_task waiter(event& e, uint32_t work) {
+    co_await e;
+    check_cycles::advance(work);
+}
+
+async_task sleeper(timer_service& ts, long at) {
+    auto t = ts.sleep_until(at);
+    co_await t;
+}
+
+void event_latency(histogram_scheduler& s) {
+    auto& h = histogram_scheduler::event_wakeup_latency();
+    h.reset();
+    check_cycles::set(1000);
+    event e;
+
+    async_task t[3] = {waiter(e, 10), waiter(e, 10), waiter(e, 10)};
+    for (auto& x: t) CHECK(s.start(x));
+    while (s.run_once()) {}
+    CHECK(h.count() == 0);
+
+    // One activation, the waiters resume 7 cycles later and 10 cycles apart
+    CHECK(e.activate());
+    check_cycles::advance(7);
+    while (s.run_once()) {}
+    CHECK((buckets(h) == std::vector<bucket>{{7, 7, 1}, {16, 17, 1}, {26, 27, 1}}));
+    CHECK(h.min() == 7 && h.max() == 27);
+}
+
+void timer_latency(histogram_scheduler& s, check_clock& clock, timer_service& ts) {
+    auto& h = ts.wakeup_latency();
+    auto events = histogram_scheduler::event_wakeup_latency().count();
+    h.reset();
+    clock.set(0);
+
+    // Fired on time, but the waiter runs 3 ticks after the deadline
+    async_task a = sleeper(ts, 10);
+    CHECK(s.start(a));
+    while (s.run_once()) {}
+    clock.set(10);
+    CHECK(ts.run_once());
+    clock.set(13);
+    while (s.run_once()) {}
+    CHECK(a.state() == cc::task_state::DONE);
+
+    // Lateness beyond 32 bits is clamped into the top bucket
+    async_task b = sleeper(ts, 20);
+    CHECK(s.start(b));
+    while (s.run_once()) {}
+    clock.set(20 + (1l << 33));
+    CHECK(ts.run_once());
+    while (s.run_once()) {}
+    CHECK(b.state() == cc::task_state::DONE);
+
+    CHECK((buckets(h) == std::vector<bucket>{{3, 3, 1}, {0xf0000000u, UINT32_MAX, 1}}));
+    CHECK(h.max() == UINT32_MAX);
+
+    // Timer waits stay out of the event histogram
+    CHECK(histogram_scheduler::event_wakeup_latency().count() == events);
+}
+
+}
+
+void check_histogram() {
+    auto& s = histogram_scheduler::get_instance();
+    static check_clock clock;
+    static timer_service ts{clock};
+    bucket_bounds();
+    event_latency(s);
+    timer_latency(s, clock, ts);
+}
@@ -0,0 +1,180 @@
+#include <coronimo/scheduler.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Deferred log: format_log_message() for every supported conversion, sign
+ * extension and truncation, the ring overwriting its oldest entries and counting
+ * them as lost, draining in parts, and the dump carrying each format string once.
+ * The dump is written out for tools/log2text, whose output the Makefile's run
+ * target compares with log.expected.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct log_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr size_t log_size = 8;
+    static constexpr uint32_t cycles_per_us = 10;
+    using cycle_counter = check_cycles;
+};
+using log_scheduler = cc::scheduler<log_config>;
+using async_task = log_scheduler::async_task_type;
+
+std::string format(char const* f, std::vector<uint64_t> args, size_t arg_size = sizeof(uintptr_t), bool strings = true) {
+    char out[128];
+    size_t n = cc::format_log_message(out, sizeof(out), f, args.data(), args.size(), arg_size, strings);
+    CHECK(n == std::strlen(out));
+    return out;
+}
+
+void formatting() {
+    CHECK(format("plain", {}) == "plain");
+    CHECK(format("%d %i %u", {uint64_t(-5), 7, 42}) == "-5 7 42");
+    CHECK(format("%x %X %o %c %%", {0xbeef, 0xbeef, 8, 'z'}) == "beef BEEF 10 z %");
+    CHECK(format("[%5d|%-4u|%04x|%+d]", {12, 3, 0xab, 9}) == "[   12|3   |00ab|+9]");
+    CHECK(format("%p", {0x1234}) == "0x1234");
+    CHECK(format("%s!", {reinterpret_cast<uintptr_t>("text")}) == "text!");
+
+    // Length modifiers are skipped, every argument being a word
+    CHECK(format("%lu %zu %lld %hhx", {1, 2, uint64_t(-3), 0xff}) == "1 2 -3 ff");
+
+    // Words recorded on a 32-bit target are sign-extended from 32 bits for %d only
+    CHECK(format("%d %u", {0xfffffffbu, 0xfffffffbu}, 4) == "-5 4294967291");
+
+    // On the host %s shows the address, as does a null string
+    CHECK(format("%s", {0x2000}, 4, false) == "0x2000");
+    CHECK(format("%s", {0}) == "0x0");
+
+    // Missing arguments read as 0, unknown conversions are kept
+    CHECK(format("%d %x", {}) == "0 0");
+    CHECK(format("%q%d", {1}) == "%q1");
+
+    // Truncated to the buffer, always terminated
+    char small[8];
+    uint64_t big = 123456789;
+    CHECK(cc::format_log_message(small, sizeof(small), "abcdefghij", nullptr, 0) == 7);
+    CHECK(std::strcmp(small, "abcdefg") == 0);
+    CHECK(cc::format_log_message(small, 5, "%d", &big, 1) == 4);
+    CHECK(std::strcmp(small, "1234") == 0);
+    CHECK(cc::format_log_message(small, sizeof(small), "ab%dcd", &big, 1) == 7);
+    CHECK(std::strcmp(small, "ab12345") == 0);
+    small[0] = 'x';
+    CHECK(cc::format_log_message(small, 0, "abc", nullptr, 0) == 0 && small[0] == 'x');
+}
+
+/* Logs steps first to last, alternating two formats, one every 10 cycles */
+void log_steps(int first, int last) {
+    for (int i = first; i <= last; i++) {
+        check_cycles::set(uint32_t(i) * 10);
+        if (i % 2 == 0) {
+            log_scheduler::log("step %d of %u, delta %d", i, 11u, 5 - i);
+        } else {
+            log_scheduler::log("flags %04x '%c'", i * 0x11, 'a' + i);
+        }
+    }
+}
+
+struct drained {
+    uint32_t timestamp;
+    std::string text;
+};
+
+std::vector<drained> drain(size_t max = SIZE_MAX) {
+    std::vector<drained> v;
+    log_scheduler::log_buffer().drain([&](uint32_t t, char const* text, size_t n) {
+        CHECK(std::strlen(text) == n);
+        v.push_back({t, text});
+    }, max);
+    return v;
+}
+
+void ring_overwrites() {
+    auto& ring = log_scheduler::log_buffer();
+    ring.clear();
+
+    // 11 entries into 8 slots, the 3 oldest are lost
+    log_steps(0, 10);
+    CHECK(ring.size() == 8 && ring.capacity() == 8);
+
+    auto first = drain(3);
+    CHECK(ring.lost() == 3 && ring.size() == 5);
+    CHECK(first.size() == 3);
+    CHECK(first[0].timestamp == 30 && first[0].text == "flags 0033 'd'");
+    CHECK(first[1].timestamp == 40 && first[1].text == "step 4 of 11, delta 1");
+    CHECK(first[2].text == "flags 0055 'f'");
+
+    auto rest = drain();
+    CHECK(rest.size() == 5 && ring.size() == 0);
+    CHECK(rest.back().timestamp == 100 && rest.back().text == "step 10 of 11, delta -5");
+    CHECK(drain().empty());
+
+    // Draining kept up, nothing more is lost until the ring overflows again
+    log_steps(0, 7);
+    CHECK(drain().size() == 8 && ring.lost() == 3);
+    ring.clear();
+    CHECK(ring.lost() == 0 && ring.size() == 0);
+
+    // Scheduler internals log into the same ring
+    async_task t = [](void) -> async_task { co_return; }();
+    auto internal = drain();
+    CHECK(!internal.empty() && internal[0].text.rfind("async_task: allocating ", 0) == 0);
+}
+
+void dumped() {
+    auto& ring = log_scheduler::log_buffer();
+    ring.clear();
+    log_steps(0, 10);
+
+    std::vector<uint8_t> data;
+    ring.dump([&](void const* p, size_t n) {
+        auto bytes = static_cast<uint8_t const*>(p);
+        data.insert(data.end(), bytes, bytes + n);
+    }, log_config::cycles_per_us);
+
+    cc::log_dump_header header;
+    CHECK(data.size() >= sizeof(header));
+    std::memcpy(&header, data.data(), sizeof(header));
+    CHECK(header.magic == cc::log_dump_header::magic_value && header.version == cc::log_dump_header::version_value);
+    CHECK(header.pointer_size == sizeof(uintptr_t) && header.cycles_per_us == log_config::cycles_per_us);
+    CHECK(header.count == 8 && header.lost == 3);
+
+    // Each format travels once, ahead of its first entry
+    size_t strings = 0, entries = 0;
+    for (size_t pos = sizeof(header); pos < data.size(); ) {
+        uint8_t tag = data[pos++];
+        if (tag == cc::log_dump_header::string_tag) {
+            uint16_t length;
+            std::memcpy(&length, &data[pos + sizeof(uintptr_t)], sizeof(length));
+            pos += sizeof(uintptr_t) + sizeof(length) + length;
+            CHECK(entries == strings);
+            strings++;
+        } else {
+            CHECK(tag == cc::log_dump_header::entry_tag);
+            uint8_t argc = data[pos + 4];
+            pos += 4 + 1 + sizeof(uintptr_t) + argc * sizeof(uintptr_t);
+            entries++;
+        }
+        CHECK(pos <= data.size());
+    }
+    CHECK(strings == 2 && entries == 8);
+
+    // Dumping does not drain
+    CHECK(ring.size() == 8);
+    write_dump("log.bin", data);
+}
+
+}
+
+void check_log() {
+    log_scheduler::get_instance();
+    formatting();
+    ring_overwrites();
+    dumped();
+}
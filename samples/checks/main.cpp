@@ -0,0 +1,63 @@
+#include "checks.h"
+
+/*
+ * Runs the feature checks in order and stops at the first failure.
+ *
+ * Usage: scheduler-checks [dump_dir]
+ *
+ * With dump_dir, checks of features that produce dumps for the host tools write
+ * them there; the Makefile's run target feeds them through the tools.
+ */
+
+struct check_entry {
+    char const* name;
+    void (*run)();
+};
+
+static check_entry const checks[] = {
+    {"task_stats", check_task_stats},
+    {"trace", check_trace},
+    {"histogram", check_histogram},
+    {"watchdog", check_watchdog},
+    {"async_stack", check_async_stack},
+    {"log", check_log},
+    {"run_loop", check_run_loop},
+    {"maybe_yield", check_maybe_yield},
+    {"handoff", check_handoff},
+    {"generator", check_generator},
+    {"edf", check_edf},
+    {"priority", check_priority},
+    {"events", check_events},
+    {"oneshot", check_oneshot},
+    {"topic", check_topic},
+    {"pool", check_pool},
+    {"rate_limiter", check_rate_limiter},
+    {"task_group", check_task_group},
+    {"detached", check_detached},
+    {"persistent", check_persistent},
+};
+
+static char const* dump_dir = nullptr;
+
+void write_dump(char const* name, std::vector<uint8_t> const& data) {
+    if (!dump_dir) return;
+
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s/%s", dump_dir, name);
+    FILE* f = std::fopen(path, "wb");
+    CHECK(f != nullptr);
+    CHECK(std::fwrite(data.data(), 1, data.size(), f) == data.size());
+    std::fclose(f);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        dump_dir = argv[1];
+    }
+    for (auto& c: checks) {
+        c.run();
+        std::printf("%s: ok\n", c.name);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * maybe_yield_awaitable: suspending on every n-th await, or once the slice would
+ * outgrow a cycle budget, given or the running task's slice budget, counted as the
+ * slices a loop of awaits is spread over.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct maybe_yield_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr uint32_t slice_budget = 100;
+    using cycle_counter = check_cycles;
+};
+using maybe_yield_scheduler = cc::scheduler<maybe_yield_config>;
+using async_task = maybe_yield_scheduler::async_task_type;
+using maybe_yield = cc::maybe_yield_awaitable<maybe_yield_scheduler>;
+
+/* Slice the test loop is running, counted from 0 */
+int slice = 0;
+
+/* How a looper paces itself, by every n-th await, a cycle budget or else the task's budget */
+struct pacing {
+    uint32_t every = 0;
+    uint32_t cycles = 0;
+};
+
+maybe_yield make_pace(pacing p) {
+    if (p.every != 0) return maybe_yield::iterations(p.every);
+    if (p.cycles != 0) return maybe_yield::cycles(p.cycles);
+    return maybe_yield{};
+}
+
+/* Iterates, each iteration taking cost cycles, and notes the slice every iteration ran in */
+async_task looper(pacing p, uint32_t cost, int iterations, std::vector<int>& slices) {
+    auto pace = make_pace(p);
+    for (int i = 0; i < iterations; i++) {
+        check_cycles::advance(cost);
+        slices.push_back(slice);
+        co_await pace;
+    }
+}
+
+/* Runs the task to completion, returns how often it suspended */
+int suspensions(maybe_yield_scheduler& s, async_task& t) {
+    slice = 0;
+    CHECK(s.start(t));
+    while (s.run_once()) {
+        slice++;
+    }
+    CHECK(t.state() == cc::task_state::DONE);
+    return slice - 1;
+}
+
+void every_nth(maybe_yield_scheduler& s) {
+    // Every 4th of 10 awaits suspends
+    std::vector<int> slices;
+    async_task t = looper({.every = 4}, 0, 10, slices);
+    CHECK(suspensions(s, t) == 2);
+    CHECK((slices == std::vector<int>{0, 0, 0, 0, 1, 1, 1, 1, 2, 2}));
+
+    // Every await suspends
+    slices.clear();
+    async_task u = looper({.every = 1}, 0, 3, slices);
+    CHECK(suspensions(s, u) == 3);
+    CHECK((slices == std::vector<int>{0, 1, 2}));
+}
+
+void cycle_budget(maybe_yield_scheduler& s) {
+    // 30 cycles an iteration in 100: the third await would overrun the slice
+    std::vector<int> slices;
+    async_task t = looper({.cycles = 100}, 30, 10, slices);
+    CHECK(suspensions(s, t) == 3);
+    CHECK((slices == std::vector<int>{0, 0, 0, 1, 1, 1, 2, 2, 2, 3}));
+
+    // An iteration as long as the budget suspends every time
+    slices.clear();
+    async_task u = looper({.cycles = 100}, 100, 3, slices);
+    CHECK(suspensions(s, u) == 3);
+}
+
+void task_budget(maybe_yield_scheduler& s) {
+    s.clear_overruns();
+
+    // The global slice budget of 100 paces like cycles(100), and no slice overruns
+    std::vector<int> slices;
+    async_task t = looper({}, 30, 10, slices);
+    CHECK(suspensions(s, t) == 3);
+    CHECK(s.overrun_count() == 0);
+
+    // The task's own budget of 200 lets six iterations share a slice
+    slices.clear();
+    async_task u = looper({}, 30, 10, slices);
+    u.set_slice_budget(200);
+    CHECK(suspensions(s, u) == 1);
+    CHECK((slices == std::vector<int>{0, 0, 0, 0, 0, 0, 1, 1, 1, 1}));
+    CHECK(s.overrun_count() == 0);
+}
+
+}
+
+void check_maybe_yield() {
+    auto& s = maybe_yield_scheduler::get_instance();
+    every_nth(s);
+    cycle_budget(s);
+    task_budget(s);
+}
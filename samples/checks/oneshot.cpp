@@ -0,0 +1,121 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include "checks.h"
+
+/*
+ * oneshot: a sent value reaches the awaiting task, a destroyed sender completes
+ * it as broken, and a destroyed oneshot disconnects its sender.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct oneshot_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+};
+using oneshot_scheduler = cc::scheduler<oneshot_config>;
+using async_task = oneshot_scheduler::async_task_type;
+
+/* Counts live instances, so the value kept in the oneshot is seen to be destroyed */
+struct tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit tracked(int v) : value(v) { live++; }
+    ~tracked() { live--; }
+};
+
+using oneshot = cc::oneshot<tracked, oneshot_scheduler>;
+
+enum class outcome { pending, value, broken };
+
+struct receiver_model {
+    oneshot::sender sender;
+    outcome result = outcome::pending;
+    int value = 0;
+};
+
+async_task receiver(receiver_model& m) {
+    oneshot r;
+    m.sender = r.get_sender();
+    CHECK(!r.get_sender().connected());
+    if (tracked* p = co_await r) {
+        m.result = outcome::value;
+        m.value = p->value;
+    } else {
+        m.result = outcome::broken;
+    }
+}
+
+void run_all(oneshot_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+void value_sent(oneshot_scheduler& s) {
+    receiver_model m;
+    {
+        async_task t = receiver(m);
+        CHECK(s.start(t));
+        run_all(s);
+        CHECK(m.result == outcome::pending && m.sender.connected());
+
+        // The sender can be moved to whoever produces the value
+        oneshot::sender moved = std::move(m.sender);
+        CHECK(!m.sender.connected() && moved.connected());
+        CHECK(!m.sender.send(1));
+
+        CHECK(moved.send(42));
+        CHECK(!moved.connected());
+        CHECK(!moved.send(43));
+        CHECK(tracked::live == 1);
+        run_all(s);
+        CHECK(m.result == outcome::value && m.value == 42);
+        CHECK(t.state() == cc::task_state::DONE);
+    }
+    // The value lived in the task's frame and went with it
+    CHECK(tracked::live == 0);
+}
+
+void sender_destroyed(oneshot_scheduler& s) {
+    receiver_model m;
+    async_task t = receiver(m);
+    CHECK(s.start(t));
+    run_all(s);
+    CHECK(m.result == outcome::pending);
+
+    m.sender = oneshot::sender{};
+    CHECK(t.state() == cc::task_state::SCHEDULED);
+    run_all(s);
+    CHECK(m.result == outcome::broken);
+    CHECK(t.state() == cc::task_state::DONE);
+    CHECK(tracked::live == 0);
+}
+
+void oneshot_destroyed(oneshot_scheduler& s) {
+    receiver_model m;
+    std::optional<async_task> t{receiver(m)};
+    CHECK(s.start(*t));
+    run_all(s);
+    CHECK(m.sender.connected());
+
+    // The receiver goes away with the oneshot in its frame
+    t.reset();
+    CHECK(!m.sender.connected());
+    CHECK(!m.sender.send(7));
+    CHECK(tracked::live == 0);
+    CHECK(m.result == outcome::pending);
+}
+
+}
+
+void check_oneshot() {
+    auto& s = oneshot_scheduler::get_instance();
+    value_sent(s);
+    sender_destroyed(s);
+    oneshot_destroyed(s);
+}
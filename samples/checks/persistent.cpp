@@ -0,0 +1,97 @@
+#include <coronimo/scheduler.h>
+#include "checks.h"
+
+/*
+ * persistent_task: restart() runs the function again in the frame of the finished
+ * run, at the same address and registry entry and with the same priority, without
+ * any allocation counted by frame_statistics(); it refuses while a run is under way.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct persistent_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool frame_stats = true;
+};
+using persistent_scheduler = cc::scheduler<persistent_config>;
+using async_task = persistent_scheduler::async_task_type;
+using event = cc::event<persistent_scheduler>;
+
+int runs = 0;
+int last_arg = 0;
+
+async_task block(event& e, int arg) {
+    if (runs++ == 0) {
+        persistent_scheduler::get_instance().set_current_priority(cc::task_priority::HIGH);
+    }
+    last_arg = arg;
+    co_await e;
+}
+
+using persistent_block = cc::persistent_task<persistent_scheduler, block>;
+
+void run_all(persistent_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+cc::frame_totals const& totals() {
+    return persistent_scheduler::frame_statistics().totals();
+}
+
+void restart_in_place(persistent_scheduler& s) {
+    event e;
+    {
+        persistent_block p;
+        CHECK(p.state() == cc::task_state::INACTIVE && !p.running());
+
+        CHECK(p.restart(e, 1));
+        run_all(s);
+        CHECK(runs == 1 && last_arg == 1);
+        CHECK(p.running() && p.state() == cc::task_state::SUSPENDED);
+
+        // Not before the run completed
+        CHECK(!p.restart(e, 2));
+        e.activate();
+        run_all(s);
+        CHECK(!p.running() && p.state() == cc::task_state::DONE);
+
+        auto table = s.snapshot();
+        CHECK(table.size() == 1);
+        void* frame = table[0].address;
+        auto allocations = totals().allocations;
+        auto bytes = totals().current_bytes;
+        CHECK(totals().live_frames == 1);
+
+        for (int i = 2; i < 100; i++) {
+            CHECK(p.restart(e, i));
+            table = s.snapshot();
+            CHECK(table.size() == 1);
+            CHECK(table[0].address == frame);
+            CHECK(table[0].priority == cc::task_priority::HIGH);
+            CHECK(totals().allocations == allocations);
+            CHECK(totals().current_bytes == bytes && totals().live_frames == 1);
+
+            run_all(s);
+            CHECK(runs == i && last_arg == i);
+            e.activate();
+            run_all(s);
+            CHECK(p.state() == cc::task_state::DONE);
+        }
+    }
+    // The frame goes with the persistent_task
+    CHECK(totals().live_frames == 0 && totals().current_bytes == 0);
+    CHECK(s.snapshot().empty());
+}
+
+}
+
+void check_persistent() {
+    auto& s = persistent_scheduler::get_instance();
+    restart_in_place(s);
+}
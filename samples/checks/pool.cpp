@@ -0,0 +1,130 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include <vector>
+#include "checks.h"
+
+/*
+ * object_pool: waiters are served first come first served, a returned object is
+ * handed straight to the first waiter so a later acquire cannot overtake it, and
+ * a waiter destroyed before it resumed passes its object on.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct pool_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+};
+using pool_scheduler = cc::scheduler<pool_config>;
+using async_task = pool_scheduler::async_task_type;
+using event = cc::event<pool_scheduler>;
+using pool = cc::object_pool<int, 2, pool_scheduler>;
+
+struct borrower_model {
+    int* object = nullptr;    ///< What the borrower got, while it holds it
+    event done;               ///< Activated to make the borrower return its object
+};
+
+std::vector<int> served;
+
+async_task borrower(pool& p, int id, borrower_model& m) {
+    auto h = co_await p.acquire();
+    CHECK(h);
+    served.push_back(id);
+    m.object = h.get();
+    co_await m.done;
+    m.object = nullptr;
+}
+
+void run_all(pool_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+void fifo_handover(pool_scheduler& s) {
+    pool p;
+    served.clear();
+
+    auto a = p.try_acquire(), b = p.try_acquire();
+    CHECK(a && b && a.get() != b.get());
+    CHECK(!p.try_acquire());
+    CHECK(p.available() == 0);
+
+    borrower_model m[4];
+    std::vector<async_task> tasks;
+    for (int i = 0; i < 3; i++) {
+        tasks.push_back(borrower(p, i, m[i]));
+        CHECK(s.start(tasks.back()));
+    }
+    run_all(s);
+    CHECK(served.empty());
+
+    // The returned object is already given to the first waiter before it runs
+    int* returned = a.get();
+    a.reset();
+    CHECK(p.available() == 0);
+    CHECK(!p.try_acquire());
+
+    // Acquiring meanwhile queues up behind everybody already waiting
+    tasks.push_back(borrower(p, 3, m[3]));
+    CHECK(s.start(tasks.back()));
+    run_all(s);
+    CHECK((served == std::vector<int>{0}));
+    CHECK(m[0].object == returned);
+
+    b.reset();
+    run_all(s);
+    CHECK((served == std::vector<int>{0, 1}));
+
+    m[0].done.activate();
+    run_all(s);
+    CHECK((served == std::vector<int>{0, 1, 2}));
+    CHECK(m[2].object == returned);
+
+    m[1].done.activate();
+    run_all(s);
+    CHECK((served == std::vector<int>{0, 1, 2, 3}));
+
+    m[2].done.activate();
+    m[3].done.activate();
+    run_all(s);
+    CHECK(p.available() == 2);
+}
+
+void destroyed_waiter_passes_on(pool_scheduler& s) {
+    pool p;
+    served.clear();
+
+    auto a = p.try_acquire(), b = p.try_acquire();
+    borrower_model m[2];
+    std::optional<async_task> first{borrower(p, 0, m[0])};
+    async_task second = borrower(p, 1, m[1]);
+    CHECK(s.start(*first) && s.start(second));
+    run_all(s);
+
+    // Handed to the first waiter, which goes away before it gets to run
+    int* returned = a.get();
+    a.reset();
+    first.reset();
+    CHECK(p.available() == 0);
+    run_all(s);
+    CHECK((served == std::vector<int>{1}));
+    CHECK(m[1].object == returned);
+
+    m[1].done.activate();
+    run_all(s);
+    b.reset();
+    CHECK(p.available() == 2);
+}
+
+}
+
+void check_pool() {
+    auto& s = pool_scheduler::get_instance();
+    fifo_handover(s);
+    destroyed_waiter_passes_on(s);
+}
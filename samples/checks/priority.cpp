@@ -0,0 +1,199 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Priority ready queue: the wait bound aging guarantees while higher levels
+ * are always ready, strict priorities without aging, and set_priority() on a
+ * queued task moving it to the back of its new level with its wait restarted.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+constexpr uint32_t aging = 8;
+constexpr size_t levels = size_t(cc::task_priority::ISR) + 1;
+
+struct aging_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+    static constexpr uint32_t priority_aging = aging;
+};
+struct strict_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool priority_scheduling = true;
+};
+
+/* Decisions any ready task waits at most, see priority_ready_queue */
+constexpr uint32_t wait_bound = (levels - 1) * aging + 2 * aging_config::max_task_count;
+
+/* A task that is always ready, recording how many decisions passed between its runs */
+struct runner_model {
+    uint32_t runs = 0;
+    uint32_t max_wait = 0;
+    uint32_t last = 0;    ///< Decision the task last ran in
+};
+
+uint32_t decisions = 0;
+bool stop = false;
+std::vector<int> ran;
+
+template <typename S>
+typename S::async_task_type runner(runner_model& m) {
+    for (;;) {
+        if (m.runs != 0) {
+            uint32_t wait = decisions - m.last - 1;
+            if (wait > m.max_wait) m.max_wait = wait;
+        }
+        m.runs++;
+        if (stop) break;
+        m.last = decisions;
+        co_await cc::yield_awaitable<S>{};
+    }
+}
+
+template <typename S>
+typename S::async_task_type job(int id) {
+    ran.push_back(id);
+    co_return;
+}
+
+template <typename S>
+void run_decisions(S& s, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        decisions++;
+        CHECK(s.run_once());
+    }
+}
+
+template <typename S>
+void run_all(S& s) {
+    while (s.run_once()) {
+        decisions++;
+    }
+}
+
+void aging_bound() {
+    using S = cc::scheduler<aging_config>;
+    auto& s = S::get_instance();
+    stop = false;
+
+    runner_model high[4], mid, low;
+    std::vector<S::async_task_type> tasks;
+    for (auto& m: high) {
+        tasks.push_back(runner<S>(m));
+        s.set_priority(tasks.back(), cc::task_priority::HIGH);
+    }
+    tasks.push_back(runner<S>(mid));
+    tasks.push_back(runner<S>(low));
+    s.set_priority(tasks.back(), cc::task_priority::LOW);
+    for (auto& t: tasks) CHECK(s.start(t));
+
+    run_decisions(s, 4000);
+    for (auto* m: {&high[0], &high[1], &high[2], &high[3], &mid, &low}) {
+        CHECK(m->runs > 1);
+        CHECK(m->max_wait <= wait_bound);
+    }
+    // Aging bounds the wait but the levels still share the processor unevenly
+    CHECK(low.runs < mid.runs && mid.runs < high[0].runs);
+
+    stop = true;
+    run_all(s);
+    for (auto& t: tasks) CHECK(t.state() == cc::task_state::DONE);
+}
+
+void strict_levels() {
+    using S = cc::scheduler<strict_config>;
+    auto& s = S::get_instance();
+    stop = false;
+
+    runner_model high[2], mid, low;
+    std::vector<S::async_task_type> tasks;
+    for (auto& m: high) {
+        tasks.push_back(runner<S>(m));
+        s.set_priority(tasks.back(), cc::task_priority::HIGH);
+    }
+    tasks.push_back(runner<S>(mid));
+    tasks.push_back(runner<S>(low));
+    s.set_priority(tasks.back(), cc::task_priority::LOW);
+    for (auto& t: tasks) CHECK(s.start(t));
+
+    // While a higher level is ready, lower ones never run; HIGH takes turns
+    run_decisions(s, 1000);
+    CHECK(mid.runs == 0 && low.runs == 0);
+    CHECK(high[0].runs == 500 && high[1].runs == 500);
+    CHECK(high[0].max_wait == 1 && high[1].max_wait == 1);
+
+    stop = true;
+    run_all(s);
+    for (auto& t: tasks) CHECK(t.state() == cc::task_state::DONE);
+}
+
+void set_priority_queued() {
+    using S = cc::scheduler<strict_config>;
+    auto& s = S::get_instance();
+
+    // Moved up, a queued task runs first; moved down, it runs last
+    ran.clear();
+    S::async_task_type a = job<S>(1), b = job<S>(2), c = job<S>(3), d = job<S>(4);
+    s.set_priority(d, cc::task_priority::LOW);
+    for (auto* t: {&a, &b, &c, &d}) CHECK(s.start(*t));
+    CHECK(s.set_priority(d, cc::task_priority::HIGH));
+    CHECK(s.set_priority(a, cc::task_priority::LOW));
+    CHECK(s.check_invariants());
+    run_all(s);
+    CHECK((ran == std::vector<int>{4, 2, 3, 1}));
+
+    // Changed away and back, a queued task goes to the back of its level
+    ran.clear();
+    S::async_task_type e = job<S>(1), f = job<S>(2), g = job<S>(3);
+    for (auto* t: {&e, &f, &g}) CHECK(s.start(*t));
+    CHECK(s.set_priority(e, cc::task_priority::HIGH));
+    CHECK(s.set_priority(e, cc::task_priority::MID));
+    run_all(s);
+    CHECK((ran == std::vector<int>{2, 3, 1}));
+}
+
+void set_priority_resets_wait() {
+    using S = cc::scheduler<aging_config>;
+    auto& s = S::get_instance();
+    stop = false;
+
+    runner_model hog, waiting;
+    S::async_task_type h = runner<S>(hog), w = runner<S>(waiting);
+    s.set_priority(h, cc::task_priority::HIGH);
+    s.set_priority(w, cc::task_priority::LOW);
+    CHECK(s.start(h) && s.start(w));
+
+    // Aged past the hog, w runs once and queues again
+    for (uint32_t i = 0; i <= wait_bound && waiting.runs == 0; i++) {
+        run_decisions(s, 1);
+    }
+    CHECK(waiting.runs == 1);
+    run_decisions(s, aging + aging / 2);
+    CHECK(waiting.runs == 1);
+
+    // Promoted with its wait kept, w would outrank the hog right away
+    CHECK(s.set_priority(w, cc::task_priority::MID));
+    run_decisions(s, 1);
+    CHECK(waiting.runs == 1);
+    run_decisions(s, wait_bound);
+    CHECK(waiting.runs > 1);
+    CHECK(waiting.max_wait <= wait_bound);
+
+    stop = true;
+    run_all(s);
+    CHECK(h.state() == cc::task_state::DONE && w.state() == cc::task_state::DONE);
+}
+
+}
+
+void check_priority() {
+    aging_bound();
+    strict_levels();
+    set_priority_queued();
+    set_priority_resets_wait();
+}
@@ -0,0 +1,116 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "checks.h"
+
+/*
+ * rate_limiter: the burst is available at once, waiters are released in the
+ * order they suspended at the time their reserved tokens have refilled, and a
+ * waiter destroyed before its release has spent its tokens all the same.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct limiter_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+};
+using limiter_scheduler = cc::scheduler<limiter_config>;
+using async_task = limiter_scheduler::async_task_type;
+using timer_service = cc::timer_service<check_clock, limiter_scheduler>;
+using rate_limiter = cc::rate_limiter<check_clock, limiter_scheduler>;
+
+using release = std::pair<int, long>;    ///< Task and the time it got its tokens
+std::vector<release> released;
+
+async_task throttled(rate_limiter& l, check_clock& clock, int id, uint32_t tokens) {
+    co_await l.acquire(tokens);
+    released.push_back({id, clock.now()});
+}
+
+void run_all(limiter_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+/* Steps the clock one tick at a time, firing timers and running tasks at each */
+void advance_to(limiter_scheduler& s, check_clock& clock, timer_service& ts, long t) {
+    while (clock.now() < t) {
+        clock.advance(1);
+        while (ts.run_once()) {}
+        run_all(s);
+    }
+}
+
+void release_order(limiter_scheduler& s, check_clock& clock, timer_service& ts) {
+    released.clear();
+    clock.set(0);
+    rate_limiter l{ts, 10, 2};
+
+    // The burst is there at once, then the bucket is empty until it refills
+    CHECK(l.try_acquire() && l.try_acquire());
+    CHECK(!l.try_acquire());
+
+    async_task t[4] = {throttled(l, clock, 0, 1), throttled(l, clock, 1, 1),
+        throttled(l, clock, 2, 1), throttled(l, clock, 3, 2)};
+    for (auto& x: t) CHECK(s.start(x));
+    run_all(s);
+    CHECK(l.waiting() == 4 && released.empty());
+
+    // Waiters have reserved what refills first, so try_acquire() gets nothing meanwhile
+    advance_to(s, clock, ts, 9);
+    CHECK(released.empty());
+    CHECK(!l.try_acquire());
+    advance_to(s, clock, ts, 45);
+    CHECK(!l.try_acquire());
+
+    // One token per interval, and the last waiter needs two
+    advance_to(s, clock, ts, 50);
+    CHECK((released == std::vector<release>{{0, 10}, {1, 20}, {2, 30}, {3, 50}}));
+    CHECK(l.waiting() == 0);
+
+    CHECK(!l.try_acquire());
+    advance_to(s, clock, ts, 59);
+    CHECK(!l.try_acquire());
+    advance_to(s, clock, ts, 60);
+    CHECK(l.try_acquire());
+    CHECK(!l.try_acquire());
+}
+
+void destroyed_waiter(limiter_scheduler& s, check_clock& clock, timer_service& ts) {
+    released.clear();
+    clock.set(100);
+    rate_limiter l{ts, 10, 2};
+    CHECK(l.try_acquire(2));
+
+    std::optional<async_task> first{throttled(l, clock, 0, 1)};
+    async_task second = throttled(l, clock, 1, 1);
+    CHECK(s.start(*first) && s.start(second));
+    run_all(s);
+    CHECK(l.waiting() == 2);
+
+    // The first waiter's token stays spent, the second one keeps its reserved time
+    advance_to(s, clock, ts, 105);
+    first.reset();
+    CHECK(l.waiting() == 1);
+    advance_to(s, clock, ts, 119);
+    CHECK(released.empty());
+    advance_to(s, clock, ts, 125);
+    CHECK((released == std::vector<release>{{1, 120}}));
+    CHECK(!ts.has_pending());
+}
+
+}
+
+void check_rate_limiter() {
+    auto& s = limiter_scheduler::get_instance();
+    check_clock clock;
+    timer_service ts{clock};
+    release_order(s, clock, ts);
+    destroyed_waiter(s, clock, ts);
+}
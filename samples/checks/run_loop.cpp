@@ -0,0 +1,94 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Run loop: run_for() returning quiescent while timers are armed but not yet due,
+ * timer_service::next_expiry() telling the caller how long it may sleep, and the
+ * deadline ending a loop that always has work.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct run_loop_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+};
+using run_loop_scheduler = cc::scheduler<run_loop_config>;
+using async_task = run_loop_scheduler::async_task_type;
+using yield = cc::yield_awaitable<run_loop_scheduler>;
+using timer_service = cc::timer_service<check_clock, run_loop_scheduler>;
+
+async_task sleeper(timer_service& ts, long at, std::vector<long>& woken) {
+    auto t = ts.sleep_until(at);
+    co_await t;
+    woken.push_back(ts.now());
+}
+
+/* Always scheduled, each slice taking one tick */
+async_task spinner(check_clock& clock, int slices) {
+    for (int i = 0; i < slices; i++) {
+        clock.advance(1);
+        co_await yield{};
+    }
+}
+
+void sleeps_until_timers(run_loop_scheduler& s, check_clock& clock, timer_service& ts) {
+    clock.set(0);
+    std::vector<long> woken;
+    async_task late = sleeper(ts, 50, woken);
+    async_task early = sleeper(ts, 30, woken);
+    CHECK(s.start(late) && s.start(early));
+
+    // Both tasks wait on timers that are not due, so the loop stops before the deadline
+    long next = -1;
+    CHECK(s.run_for(clock, 100, cc::direct_tuple{ts}) == cc::run_result::quiescent);
+    CHECK(clock.now() == 0 && woken.empty());
+    CHECK(ts.next_expiry(next) && next == 30);
+
+    // Sleeping until each expiry wakes exactly one task, at its deadline
+    while (s.run_for(clock, 100, cc::direct_tuple{ts}) == cc::run_result::quiescent && ts.next_expiry(next)) {
+        clock.set(next);
+    }
+    CHECK((woken == std::vector<long>{30, 50}));
+    CHECK(late.state() == cc::task_state::DONE && early.state() == cc::task_state::DONE);
+
+    // Nothing armed, next is left alone
+    next = -1;
+    CHECK(!ts.has_pending() && !ts.next_expiry(next) && next == -1);
+}
+
+void runs_to_deadline(run_loop_scheduler& s, check_clock& clock, timer_service& ts) {
+    clock.set(0);
+    std::vector<long> woken;
+    async_task t = spinner(clock, 100);
+    async_task u = sleeper(ts, 1000, woken);
+    CHECK(s.start(t) && s.start(u));
+
+    // A task is always scheduled, the loop runs until the deadline
+    CHECK(s.run_for(clock, 10, cc::direct_tuple{ts}) == cc::run_result::deadline);
+    CHECK(clock.now() >= 10 && t.state() == cc::task_state::SCHEDULED);
+    long next;
+    CHECK(ts.next_expiry(next) && next == 1000);
+
+    // Once the spinner is done the loop goes quiescent ahead of the timer
+    CHECK(s.run_until(clock, 500, cc::direct_tuple{ts}) == cc::run_result::quiescent);
+    CHECK(clock.now() == 100 && t.state() == cc::task_state::DONE && woken.empty());
+
+    clock.set(1000);
+    CHECK(s.run_for(clock, 10, cc::direct_tuple{ts}) == cc::run_result::quiescent);
+    CHECK((woken == std::vector<long>{1000}));
+}
+
+}
+
+void check_run_loop() {
+    auto& s = run_loop_scheduler::get_instance();
+    static check_clock clock;
+    static timer_service ts{clock};
+    sleeps_until_timers(s, clock, ts);
+    runs_to_deadline(s, clock, ts);
+}
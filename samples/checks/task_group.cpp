@@ -0,0 +1,150 @@
+#include <coronimo/scheduler.h>
+#include <optional>
+#include "checks.h"
+
+/*
+ * task_group: join() is woken by the last child to complete, spawn() refuses a
+ * task while all slots are running, and cancel() or destroying the group
+ * destroys the children, reporting how many were still running.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct group_config {
+    static constexpr size_t max_task_count = 12;
+    static constexpr size_t timer_count = 4;
+};
+using group_scheduler = cc::scheduler<group_config>;
+using async_task = group_scheduler::async_task_type;
+using event = cc::event<group_scheduler>;
+using task_group = cc::task_group<group_scheduler, 3>;
+
+/* Counts child frames alive, so destroyed children are seen to be gone */
+struct frame_marker {
+    static inline int live = 0;
+    frame_marker() { live++; }
+    ~frame_marker() { live--; }
+};
+
+async_task child(event& e) {
+    frame_marker m;
+    co_await e;
+}
+
+async_task joiner(task_group& g, bool& joined) {
+    co_await g.join();
+    joined = true;
+}
+
+void run_all(group_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+void join_after_last(group_scheduler& s) {
+    task_group g;
+    event e[3];
+    for (auto& x: e) CHECK(g.spawn(child(x)));
+    CHECK(g.running() == 3);
+
+    bool joined = false;
+    async_task j = joiner(g, joined);
+    CHECK(s.start(j));
+    run_all(s);
+    CHECK(frame_marker::live == 3);
+
+    e[0].activate();
+    e[2].activate();
+    run_all(s);
+    CHECK(g.running() == 1 && !joined);
+    CHECK(j.state() == cc::task_state::SUSPENDED);
+
+    // The scheduler wakes the joiner as the last child completes
+    e[1].activate();
+    CHECK(s.run_once());
+    CHECK(g.running() == 0);
+    CHECK(j.state() == cc::task_state::SCHEDULED);
+    run_all(s);
+    CHECK(joined);
+
+    // Nothing is left running to cancel
+    CHECK(frame_marker::live == 0);
+    CHECK(g.cancel() == 0);
+
+    // With nothing running, join() completes at once
+    joined = false;
+    async_task k = joiner(g, joined);
+    CHECK(s.start(k));
+    CHECK(s.run_once());
+    CHECK(joined);
+}
+
+void spawn_when_full(group_scheduler& s) {
+    task_group g;
+    event e[3], extra;
+    for (auto& x: e) CHECK(g.spawn(child(x)));
+
+    // Refused, the task stays with the caller
+    async_task t = child(extra);
+    CHECK(!g.spawn(std::move(t)));
+    CHECK(t.state() == cc::task_state::SUSPENDED);
+
+    // A completed child's slot is taken over
+    run_all(s);
+    e[1].activate();
+    run_all(s);
+    CHECK(g.running() == 2);
+    CHECK(g.spawn(std::move(t)));
+    CHECK(g.running() == 3);
+    run_all(s);
+    CHECK(frame_marker::live == 3);
+}
+
+void cancel_counts_running(group_scheduler& s) {
+    {
+        task_group g;
+        event e[3];
+        for (auto& x: e) CHECK(g.spawn(child(x)));
+        run_all(s);
+        e[0].activate();
+        run_all(s);
+
+        bool joined = false;
+        async_task j = joiner(g, joined);
+        CHECK(s.start(j));
+        run_all(s);
+        CHECK(!joined);
+
+        // Cancelling the running children counts as them completing
+        CHECK(g.cancel() == 2);
+        CHECK(g.running() == 0);
+        CHECK(frame_marker::live == 0);
+        run_all(s);
+        CHECK(joined);
+        CHECK(g.cancel() == 0);
+    }
+    {
+        // Destroying the group destroys its children
+        std::optional<task_group> g{std::in_place};
+        event e[2];
+        for (auto& x: e) CHECK(g->spawn(child(x)));
+        run_all(s);
+        CHECK(frame_marker::live == 2);
+        g.reset();
+        CHECK(frame_marker::live == 0);
+    }
+}
+
+}
+
+void check_task_group() {
+    auto& s = group_scheduler::get_instance();
+    join_after_last(s);
+    spawn_when_full(s);
+    CHECK(frame_marker::live == 0);
+    cancel_counts_running(s);
+}
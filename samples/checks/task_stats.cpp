@@ -0,0 +1,113 @@
+#include <coronimo/scheduler.h>
+#include "checks.h"
+
+/*
+ * Per-task runtime accounting: snapshot() reporting how often each task ran, for
+ * how long in total and at most, and how long it waited in the ready queue, all
+ * measured with the cycle counter across its wrap-around.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct stats_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr bool task_stats = true;
+    using cycle_counter = check_cycles;
+};
+using stats_scheduler = cc::scheduler<stats_config>;
+using async_task = stats_scheduler::async_task_type;
+using async_func = stats_scheduler::async_func_type;
+using yield = cc::yield_awaitable<stats_scheduler>;
+
+/* Runs one slice per cost, each taking that many cycles */
+template <size_t N>
+async_task worker(uint32_t const (&costs)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (i != 0) {
+            co_await yield{};
+        }
+        check_cycles::advance(costs[i]);
+    }
+}
+
+async_func nested(uint32_t cost) {
+    check_cycles::advance(cost);
+    co_await yield{};
+    check_cycles::advance(cost);
+}
+
+async_task caller(uint32_t cost) {
+    co_await nested(cost);
+}
+
+stats_scheduler::task_info const* find(stats_scheduler::task_table const& table, void* address) {
+    for (auto& row: table) {
+        if (row.address == address) return &row;
+    }
+    return nullptr;
+}
+
+void slices_and_queueing(stats_scheduler& s) {
+    // Close to the wrap-around, so that readings wrap in the middle of the run
+    check_cycles::set(UINT32_MAX - 50);
+
+    static constexpr uint32_t a_costs[] = {10, 30, 5};
+    static constexpr uint32_t b_costs[] = {20, 20};
+    async_task a = worker(a_costs);
+    void* a_address = s.snapshot()[0].address;
+    async_task b = worker(b_costs);
+    CHECK(s.start(a) && s.start(b));
+
+    // Both wait 100 cycles before the first of them runs
+    check_cycles::advance(100);
+    while (s.run_once()) {}
+
+    auto table = s.snapshot();
+    CHECK(table.size() == 2);
+    auto* ra = find(table, a_address);
+    auto* rb = &table[0] == ra ? &table[1] : &table[0];
+    CHECK(ra != nullptr);
+    CHECK(ra->state == cc::task_state::DONE && rb->state == cc::task_state::DONE);
+
+    // a runs at 100, 130 and 180 after it was started, b at 110 and 160
+    CHECK(ra->stats.resumes == 3 && rb->stats.resumes == 2);
+    CHECK(ra->stats.run_cycles == 45 && ra->stats.max_slice_cycles == 30);
+    CHECK(rb->stats.run_cycles == 40 && rb->stats.max_slice_cycles == 20);
+    CHECK(ra->stats.queue_cycles == 100 + 20 + 20 && ra->stats.max_queue_cycles == 100);
+    CHECK(rb->stats.queue_cycles == 110 + 30 && rb->stats.max_queue_cycles == 110);
+}
+
+void nested_slices(stats_scheduler& s) {
+    check_cycles::set(0);
+    async_task t = caller(7);
+    CHECK(s.start(t));
+
+    // Suspended inside the async_func, the task shows one nested frame
+    CHECK(s.run_once());
+    auto table = s.snapshot();
+    CHECK(table.size() == 1);
+    CHECK(table[0].state == cc::task_state::SCHEDULED && table[0].callstack_depth == 1);
+    CHECK(table[0].stats.resumes == 1 && table[0].stats.run_cycles == 7);
+
+    // Time spent in async_func frames counts for the task awaiting them
+    check_cycles::advance(3);
+    CHECK(s.run_once());
+    CHECK(!s.run_once());
+    table = s.snapshot();
+    CHECK(table[0].state == cc::task_state::DONE && table[0].callstack_depth == 0);
+    CHECK(table[0].stats.resumes == 2 && table[0].stats.run_cycles == 14);
+    CHECK(table[0].stats.max_slice_cycles == 7);
+    CHECK(table[0].stats.queue_cycles == 3 && table[0].stats.max_queue_cycles == 3);
+}
+
+}
+
+void check_task_stats() {
+    auto& s = stats_scheduler::get_instance();
+    slices_and_queueing(s);
+    nested_slices(s);
+}
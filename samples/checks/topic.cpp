@@ -0,0 +1,153 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * topic: in lag mode a subscriber falling behind skips ahead and counts what it
+ * missed; with backpressure publish() fails until the slowest subscriber moved
+ * on, and a publisher waiting on space() resumes then.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct topic_config {
+    static constexpr size_t max_task_count = 8;
+    static constexpr size_t timer_count = 4;
+};
+using topic_scheduler = cc::scheduler<topic_config>;
+using async_task = topic_scheduler::async_task_type;
+using event = cc::event<topic_scheduler>;
+using lag_topic = cc::topic<int, 4, topic_scheduler, cc::topic_overflow::lag>;
+using backpressure_topic = cc::topic<int, 4, topic_scheduler, cc::topic_overflow::backpressure>;
+
+struct reader_model {
+    std::vector<int> messages;
+    uint32_t missed = 0;        ///< Sum of what the reads reported
+    uint32_t sub_missed = 0;    ///< The subscriber's own count
+};
+
+/* Reads every message as soon as it can, or one per activation of gate if given */
+template <typename T>
+async_task reader(T& t, reader_model& m, event* gate) {
+    typename T::subscriber sub{t};
+    for (;;) {
+        if (gate) {
+            co_await *gate;
+        }
+        auto r = co_await sub.next();
+        if (r) {
+            m.messages.push_back(*r.message);
+        }
+        m.missed += r.missed;
+        m.sub_missed = sub.missed();
+    }
+}
+
+template <typename T>
+async_task publisher(T& t, int first, int count, int& published) {
+    for (int i = first; i < first + count; i++) {
+        while (!t.publish(i)) {
+            co_await t.space();
+        }
+        published++;
+    }
+}
+
+void run_all(topic_scheduler& s) {
+    while (s.run_once()) {
+        CHECK(s.check_invariants());
+    }
+}
+
+void lag_skips_ahead(topic_scheduler& s) {
+    lag_topic t;
+    reader_model fast, slow;
+    event gate;
+    async_task f = reader(t, fast, nullptr), w = reader(t, slow, &gate);
+    CHECK(s.start(f) && s.start(w));
+    run_all(s);
+
+    // The publisher never waits, however far behind a subscriber is
+    for (int i = 0; i < 10; i++) {
+        CHECK(t.publish(i));
+        run_all(s);
+    }
+    CHECK(fast.messages.size() == 10 && fast.missed == 0);
+
+    // The slow one gets the oldest message still there and learns what it missed
+    gate.activate();
+    run_all(s);
+    CHECK((slow.messages == std::vector<int>{6}));
+    CHECK(slow.missed == 6 && slow.sub_missed == 6);
+    for (int i = 0; i < 3; i++) {
+        gate.activate();
+        run_all(s);
+    }
+    CHECK((slow.messages == std::vector<int>{6, 7, 8, 9}));
+    CHECK(slow.missed == 6 && slow.sub_missed == 6);
+
+    // Falling behind again adds to the count
+    for (int i = 10; i < 16; i++) {
+        CHECK(t.publish(i));
+        run_all(s);
+    }
+    gate.activate();
+    run_all(s);
+    CHECK(slow.messages.back() == 12);
+    CHECK(slow.missed == 8 && slow.sub_missed == 8);
+    CHECK(fast.missed == 0 && fast.messages.size() == 16);
+}
+
+void backpressure_waits(topic_scheduler& s) {
+    backpressure_topic t;
+    reader_model fast, slow;
+    event gate;
+    async_task f = reader(t, fast, nullptr), w = reader(t, slow, &gate);
+    CHECK(s.start(f) && s.start(w));
+    run_all(s);
+
+    for (int i = 0; i < 4; i++) CHECK(t.publish(i));
+    run_all(s);
+    CHECK(fast.messages.size() == 4);
+
+    // Full while the slow subscriber has read nothing, or still holds what it read
+    CHECK(!t.writable() && !t.publish(4));
+    gate.activate();
+    run_all(s);
+    CHECK((slow.messages == std::vector<int>{0}));
+    CHECK(!t.writable() && !t.publish(4));
+
+    // A publisher waiting for space resumes once the slow one moved on
+    int published = 0;
+    async_task p = publisher(t, 4, 2, published);
+    CHECK(s.start(p));
+    run_all(s);
+    CHECK(published == 0 && p.state() == cc::task_state::SUSPENDED);
+    gate.activate();
+    run_all(s);
+    CHECK((slow.messages == std::vector<int>{0, 1}));
+    CHECK(published == 1 && p.state() == cc::task_state::SUSPENDED);
+    gate.activate();
+    run_all(s);
+    CHECK(published == 2 && p.state() == cc::task_state::DONE);
+
+    // Nothing is dropped for anyone
+    for (int i = 0; i < 4; i++) {
+        gate.activate();
+        run_all(s);
+    }
+    CHECK((slow.messages == std::vector<int>{0, 1, 2, 3, 4, 5}));
+    CHECK((fast.messages == std::vector<int>{0, 1, 2, 3, 4, 5}));
+    CHECK(slow.missed == 0 && fast.missed == 0);
+}
+
+}
+
+void check_topic() {
+    auto& s = topic_scheduler::get_instance();
+    lag_skips_ahead(s);
+    backpressure_waits(s);
+}
@@ -0,0 +1,194 @@
+#include <coronimo/scheduler.h>
+#include <cstring>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Trace ring: the records dispatch, async_func calls, events and timers leave,
+ * in order and attributed to the running task, and the dump of a ring that
+ * wrapped holding the newest records and counting the lost ones. The dump of the
+ * first run is written out for tools/trace2chrome.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct trace_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr size_t trace_size = 32;
+    static constexpr uint32_t cycles_per_us = 100;
+    using cycle_counter = check_cycles;
+};
+using trace_scheduler = cc::scheduler<trace_config>;
+using async_task = trace_scheduler::async_task_type;
+using async_func = trace_scheduler::async_func_type;
+using event = cc::event<trace_scheduler>;
+using yield = cc::yield_awaitable<trace_scheduler>;
+using timer_service = cc::timer_service<check_clock, trace_scheduler>;
+
+using kind = cc::trace_event;
+
+async_func wait_in_func(event& e) {
+    check_cycles::advance(1);
+    co_await e;
+    check_cycles::advance(1);
+}
+
+async_task waiter(event& e) {
+    co_await wait_in_func(e);
+}
+
+async_task activator(event& e) {
+    check_cycles::advance(1);
+    e.activate();
+    co_return;
+}
+
+async_task sleeper(timer_service& ts) {
+    auto t = ts.sleep_for(10);
+    co_await t;
+    auto aborted = ts.sleep_for(10);
+}
+
+async_task spinner(int slices) {
+    for (int i = 0; i < slices; i++) {
+        check_cycles::advance(1);
+        co_await yield{};
+    }
+}
+
+struct parsed_dump {
+    std::vector<uint8_t> data;
+    cc::trace_dump_header header;
+    std::vector<cc::trace_record> records;
+};
+
+parsed_dump dump_trace() {
+    parsed_dump d;
+    trace_scheduler::trace_buffer().dump([&](void const* p, size_t n) {
+        auto bytes = static_cast<uint8_t const*>(p);
+        d.data.insert(d.data.end(), bytes, bytes + n);
+    }, trace_config::cycles_per_us);
+
+    CHECK(d.data.size() >= sizeof(d.header));
+    std::memcpy(&d.header, d.data.data(), sizeof(d.header));
+    CHECK(d.header.magic == cc::trace_dump_header::magic_value);
+    CHECK(d.header.version == cc::trace_dump_header::version_value);
+    CHECK(d.header.pointer_size == sizeof(uintptr_t) && d.header.record_size == sizeof(cc::trace_record));
+    CHECK(d.header.cycles_per_us == trace_config::cycles_per_us);
+    CHECK(d.data.size() == sizeof(d.header) + d.header.count * sizeof(cc::trace_record));
+
+    d.records.resize(d.header.count);
+    std::memcpy(d.records.data(), d.data.data() + sizeof(d.header), d.header.count * sizeof(cc::trace_record));
+    return d;
+}
+
+bool is(cc::trace_record const& r, kind k, void const* subject, void const* task, uint8_t arg = 0) {
+    return r.kind == k && r.subject == reinterpret_cast<uintptr_t>(subject)
+        && r.task == reinterpret_cast<uintptr_t>(task) && r.arg == arg;
+}
+
+constexpr auto suspended = uint8_t(cc::task_state::SUSPENDED);
+constexpr auto done = uint8_t(cc::task_state::DONE);
+
+void task_timeline(trace_scheduler& s, check_clock& clock, timer_service& ts) {
+    trace_scheduler::trace_buffer().clear();
+    check_cycles::set(1000);
+    event e;
+
+    async_task w = waiter(e);
+    void* wa = s.snapshot()[0].address;
+    async_task a = activator(e);
+    auto table = s.snapshot();
+    void* aa = table[0].address == wa ? table[1].address : table[0].address;
+    CHECK(s.start(w) && s.start(a));
+    while (s.run_once()) {}
+
+    // w calls into wait_in_func and suspends in it, a wakes it, w returns and completes
+    auto d = dump_trace();
+    CHECK(d.header.count == 9 && d.header.lost == 0);
+    auto& r = d.records;
+    void* func = reinterpret_cast<void*>(r[1].subject);
+    CHECK(is(r[0], kind::task_resume, wa, wa));
+    CHECK(is(r[1], kind::func_push, func, wa, 1));
+    CHECK(is(r[2], kind::task_suspend, wa, wa, suspended));
+    CHECK(is(r[3], kind::task_resume, aa, aa));
+    CHECK(is(r[4], kind::event_activate, &e, aa));
+    CHECK(is(r[5], kind::task_suspend, aa, aa, done));
+    CHECK(is(r[6], kind::task_resume, wa, wa));
+    CHECK(is(r[7], kind::func_pop, func, wa, 1));
+    CHECK(is(r[8], kind::task_suspend, wa, wa, done));
+    CHECK(func != wa && func != aa && func != nullptr);
+
+    // Stamped with the cycle counter as the tasks advance it
+    uint32_t stamps[] = {1000, 1000, 1001, 1001, 1002, 1002, 1002, 1003, 1003};
+    for (size_t i = 0; i < 9; i++) CHECK(r[i].timestamp == stamps[i]);
+
+    // Timers are armed and aborted by the task, but fire outside of any task
+    async_task t = sleeper(ts);
+    void* ta = nullptr;
+    for (auto& row: s.snapshot()) {
+        if (row.state == cc::task_state::SUSPENDED) ta = row.address;
+    }
+    CHECK(s.start(t));
+    while (s.run_once()) {}
+    clock.advance(10);
+    CHECK(ts.run_once());
+    while (s.run_once()) {}
+    CHECK(t.state() == cc::task_state::DONE);
+
+    d = dump_trace();
+    CHECK(d.header.count == 18 && d.header.lost == 0);
+    auto& q = d.records;
+    void* timer = reinterpret_cast<void*>(q[10].subject);
+    CHECK(is(q[9], kind::task_resume, ta, ta));
+    CHECK(is(q[10], kind::timer_arm, timer, ta));
+    CHECK(is(q[11], kind::task_suspend, ta, ta, suspended));
+    CHECK(is(q[12], kind::timer_fire, timer, nullptr));
+    CHECK(q[13].kind == kind::event_activate && q[13].task == 0);
+    CHECK(is(q[14], kind::task_resume, ta, ta));
+    CHECK(q[15].kind == kind::timer_arm && q[15].subject != q[10].subject);
+    CHECK(is(q[16], kind::timer_abort, reinterpret_cast<void*>(q[15].subject), ta));
+    CHECK(is(q[17], kind::task_suspend, ta, ta, done));
+
+    // Five slices, which the Makefile's run target expects trace2chrome to turn into run slices
+    write_dump("trace.bin", d.data);
+}
+
+void wrapped(trace_scheduler& s) {
+    trace_scheduler::trace_buffer().clear();
+    check_cycles::set(0);
+
+    // A resume and a suspend per slice, 21 slices
+    async_task t = spinner(20);
+    CHECK(s.start(t));
+    while (s.run_once()) {}
+    CHECK(trace_scheduler::trace_buffer().size() == trace_config::trace_size);
+
+    // The newest records are kept, oldest first, and the others are counted as lost
+    auto d = dump_trace();
+    CHECK(d.header.count == trace_config::trace_size);
+    CHECK(d.header.lost == 42 - trace_config::trace_size);
+    for (size_t i = 0; i < d.records.size(); i++) {
+        auto& r = d.records[i];
+        CHECK(r.kind == (i % 2 == 0 ? kind::task_resume : kind::task_suspend));
+        // Slice k resumes at k and suspends at k + 1, but for the last one that does no work
+        if (i + 1 < d.records.size()) {
+            CHECK(r.timestamp == (d.header.lost + i + 1) / 2);
+        }
+    }
+    CHECK(d.records.back().arg == done && d.records.back().timestamp == 20);
+}
+
+}
+
+void check_trace() {
+    auto& s = trace_scheduler::get_instance();
+    static check_clock clock;
+    static timer_service ts{clock};
+    task_timeline(s, clock, ts);
+    wrapped(s);
+}
@@ -0,0 +1,152 @@
+#include <coronimo/scheduler.h>
+#include <vector>
+#include "checks.h"
+
+/*
+ * Slice-overrun watchdog: only slices longer than the task's budget, its own or
+ * the global one, are reported, once each, to the hook and the overrun log, with
+ * the innermost async_func frame the task suspended in; the log keeps the most
+ * recent overruns.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+namespace {
+
+struct watchdog_config {
+    static constexpr size_t max_task_count = 4;
+    static constexpr size_t timer_count = 4;
+    static constexpr uint32_t slice_budget = 100;
+    static constexpr uint32_t overrun_log_size = 2;
+    using cycle_counter = check_cycles;
+};
+using watchdog_scheduler = cc::scheduler<watchdog_config>;
+using async_task = watchdog_scheduler::async_task_type;
+using async_func = watchdog_scheduler::async_func_type;
+using yield = cc::yield_awaitable<watchdog_scheduler>;
+
+std::vector<cc::slice_overrun> reported;
+
+void hook(cc::slice_overrun const& o) {
+    reported.push_back(o);
+}
+
+/* Runs one slice per cost, each taking that many cycles */
+async_task worker(std::vector<uint32_t> costs) {
+    for (size_t i = 0; i < costs.size(); i++) {
+        if (i != 0) {
+            co_await yield{};
+        }
+        check_cycles::advance(costs[i]);
+    }
+}
+
+async_func nested(uint32_t cost) {
+    check_cycles::advance(cost);
+    co_await yield{};
+}
+
+async_task caller(uint32_t cost) {
+    co_await nested(cost);
+}
+
+void* address_of_only_task(watchdog_scheduler& s) {
+    auto table = s.snapshot();
+    CHECK(table.size() == 1);
+    return table[0].address;
+}
+
+void run_all(watchdog_scheduler& s) {
+    while (s.run_once()) {}
+}
+
+void global_budget(watchdog_scheduler& s) {
+    reported.clear();
+    s.clear_overruns();
+
+    // Only the slice over 100 cycles is reported, a slice of exactly 100 is within budget
+    async_task t = worker({50, 150, 100, 80});
+    void* task = address_of_only_task(s);
+    CHECK(s.start(t));
+    run_all(s);
+
+    CHECK(reported.size() == 1 && s.overrun_count() == 1);
+    auto& o = reported[0];
+    CHECK(o.task == task && o.frame == task && o.callstack_depth == 0);
+    CHECK(o.cycles == 150 && o.budget == 100);
+}
+
+void own_budget(watchdog_scheduler& s) {
+    reported.clear();
+    s.clear_overruns();
+
+    // A task's own budget replaces the global one either way
+    async_task generous = worker({150});
+    generous.set_slice_budget(200);
+    CHECK(s.start(generous));
+    run_all(s);
+    CHECK(reported.empty());
+
+    async_task strict = worker({30});
+    void* task = nullptr;
+    for (auto& row: s.snapshot()) {
+        if (row.state == cc::task_state::SUSPENDED) task = row.address;
+    }
+    strict.set_slice_budget(20);
+    CHECK(s.start(strict));
+    run_all(s);
+    CHECK(reported.size() == 1);
+    CHECK(reported[0].task == task && reported[0].cycles == 30 && reported[0].budget == 20);
+}
+
+void nested_frame(watchdog_scheduler& s) {
+    reported.clear();
+    s.clear_overruns();
+
+    // The overrun is attributed to the async_func the task suspended in
+    async_task t = caller(120);
+    void* task = address_of_only_task(s);
+    CHECK(s.start(t));
+    CHECK(s.run_once());
+    CHECK(reported.size() == 1);
+    CHECK(reported[0].task == task && reported[0].frame != task && reported[0].frame != nullptr);
+    CHECK(reported[0].callstack_depth == 1 && reported[0].cycles == 120);
+    run_all(s);
+    CHECK(reported.size() == 1);
+}
+
+void log_keeps_recent(watchdog_scheduler& s) {
+    reported.clear();
+    s.clear_overruns();
+
+    // Without a hook overruns are still logged, the log holding the last two
+    watchdog_scheduler::set_overrun_hook(nullptr);
+    async_task t = worker({101, 102, 103});
+    CHECK(s.start(t));
+    run_all(s);
+    CHECK(reported.empty());
+    CHECK(s.overrun_count() == 3);
+
+    std::vector<uint32_t> logged;
+    s.for_each_overrun([&](cc::slice_overrun const& o) { logged.push_back(o.cycles); });
+    CHECK((logged == std::vector<uint32_t>{102, 103}));
+
+    s.clear_overruns();
+    logged.clear();
+    s.for_each_overrun([&](cc::slice_overrun const& o) { logged.push_back(o.cycles); });
+    CHECK(s.overrun_count() == 0 && logged.empty());
+    watchdog_scheduler::set_overrun_hook(hook);
+}
+
+}
+
+void check_watchdog() {
+    auto& s = watchdog_scheduler::get_instance();
+    watchdog_scheduler::set_overrun_hook(hook);
+    global_budget(s);
+    own_budget(s);
+    nested_frame(s);
+    log_keeps_recent(s);
+    watchdog_scheduler::set_overrun_hook(nullptr);
+}
@@ -0,0 +1,271 @@
+#include <coronimo/scheduler.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+
+/*
+ * Randomized scheduler stress and soak harness.
+ *
+ * Usage: scheduler-stress [seed] [steps]
+ *
+ * Each step the driver picks one action at random: run a task, advance the
+ * clock and fire timers, activate an event, spawn a task, cancel (destroy) a
+ * task that has not finished, reap finished tasks, or wake every suspended
+ * task through schedule_all_suspended(). Tasks themselves run a
+ * random script of yields, event waits, sleeps, any_of waits and nested
+ * async_func calls. After every step the scheduler invariants and the
+ * harness model are checked; the first violation aborts with the seed and
+ * step number, so a failure can be replayed exactly.
+ *
+ * At the end the system is driven to quiescence and every task must finish.
+ * The summary is printed as a single JSON object.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+struct clock_tick {
+    using time_type = long;
+    using duration_type = long;
+
+    time_type now() { return now_; }
+    void advance(duration_type d) { now_ += d; }
+private:
+    time_type now_ = 0;
+};
+
+static_assert(cc::Clock<clock_tick>, "This is no clock");
+
+struct stress_scheduler_config {
+    static constexpr size_t max_task_count = 32;
+    static constexpr size_t timer_count = 16;
+};
+using stress_scheduler = cc::scheduler<stress_scheduler_config>;
+using yield = cc::yield_awaitable<stress_scheduler>;
+using event = cc::event<stress_scheduler>;
+using timer_service = cc::timer_service<clock_tick, stress_scheduler>;
+using async_task = stress_scheduler::async_task_type;
+using async_func = stress_scheduler::async_func_type;
+template <typename ...A> struct app_any_of : cc::any_of_awaitable<stress_scheduler, A...> {};
+template <typename ...A> app_any_of(A&&...) -> app_any_of<A...>;
+
+/* More slots than registry entries, so spawning into a full scheduler is exercised too */
+constexpr size_t slot_count = stress_scheduler_config::max_task_count + 8;
+constexpr size_t event_count = 4;
+constexpr unsigned max_depth = 4;
+
+struct world {
+    clock_tick clock;
+    timer_service ts{clock};
+    event events[event_count];
+};
+
+/* What the harness expects of a task, maintained by the task itself */
+struct slot_model {
+    std::optional<async_task> task;
+    unsigned depth = 0;      ///< async_func frames entered and not yet left
+    bool finished = false;   ///< body ran to its co_return
+};
+
+struct counters {
+    size_t resumes = 0;
+    size_t spawns = 0;
+    size_t spawn_rejects = 0;
+    size_t cancels = 0;
+    size_t reaps = 0;
+    size_t activations = 0;
+    size_t timer_fires = 0;
+};
+
+enum class op { yield, wait_event, sleep, any_of, call, count };
+
+using rng_type = std::mt19937_64;
+
+static unsigned pick(rng_type& rng, unsigned n) {
+    return std::uniform_int_distribution<unsigned>(0, n - 1)(rng);
+}
+
+async_func script(world& w, slot_model& m, uint64_t seed, unsigned ops, unsigned depth) {
+    rng_type rng(seed);
+    m.depth++;
+    for (unsigned i = 0; i < ops; i++) {
+        switch (static_cast<op>(pick(rng, static_cast<unsigned>(op::count)))) {
+            case op::yield:
+                co_await yield{};
+                break;
+            case op::wait_event:
+                co_await w.events[pick(rng, event_count)];
+                break;
+            case op::sleep: {
+                auto t = w.ts.sleep_for(pick(rng, 8));
+                co_await t;
+                break;
+            }
+            case op::any_of: {
+                auto t = w.ts.sleep_for(pick(rng, 16));
+                auto a1 = w.events[pick(rng, event_count)].create_awaitable();
+                auto a2 = t.operator co_await();
+                auto any = app_any_of{a1, a2};
+                co_await any;
+                break;
+            }
+            case op::call:
+                if (depth < max_depth) {
+                    co_await script(w, m, rng(), 1 + pick(rng, 4), depth + 1);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    m.depth--;
+}
+
+async_task worker(world& w, slot_model& m, uint64_t seed, unsigned ops) {
+    rng_type rng(seed);
+    for (unsigned i = 0; i < ops; i++) {
+        switch (static_cast<op>(pick(rng, static_cast<unsigned>(op::count)))) {
+            case op::yield:
+                co_await yield{};
+                break;
+            case op::wait_event:
+                co_await w.events[pick(rng, event_count)];
+                break;
+            case op::sleep: {
+                auto t = w.ts.sleep_for(pick(rng, 8));
+                co_await t;
+                break;
+            }
+            case op::any_of: {
+                auto t = w.ts.sleep_for(pick(rng, 16));
+                auto a1 = w.events[pick(rng, event_count)].create_awaitable();
+                auto a2 = t.operator co_await();
+                auto any = app_any_of{a1, a2};
+                co_await any;
+                break;
+            }
+            case op::call:
+                co_await script(w, m, rng(), 1 + pick(rng, 4), 1);
+                break;
+            default:
+                break;
+        }
+    }
+    m.finished = true;
+}
+
+static uint64_t seed_;
+static size_t step_;
+
+[[noreturn]] static void fail(char const* what, size_t slot) {
+    std::fprintf(stderr, "invariant violated: %s (seed %llu, step %zu, slot %zu)\n",
+        what, static_cast<unsigned long long>(seed_), step_, slot);
+    std::exit(EXIT_FAILURE);
+}
+
+static void check(stress_scheduler& s, slot_model (&slots)[slot_count]) {
+    if (!s.check_invariants()) fail("scheduler", 0);
+
+    for (size_t i = 0; i < slot_count; i++) {
+        auto& m = slots[i];
+        if (!m.task) continue;
+        switch (m.task->state()) {
+            case cc::task_state::ACTIVE: fail("task left ACTIVE", i);
+            case cc::task_state::ZOMBIE: fail("task became ZOMBIE", i);
+            case cc::task_state::DONE: if (!m.finished) fail("DONE before co_return", i); break;
+            default: if (m.finished) fail("finished but not DONE", i); break;
+        }
+        if (m.task->callstack_depth() != m.depth) fail("callstack depth mismatch", i);
+    }
+}
+
+static size_t live_tasks(slot_model (&slots)[slot_count]) {
+    size_t n = 0;
+    for (auto& m: slots) {
+        if (m.task) n++;
+    }
+    return n;
+}
+
+int main(int argc, char** argv)
+{
+    seed_ = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 1;
+    size_t steps = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : 1000000;
+
+    auto& s = stress_scheduler::get_instance();
+    rng_type rng(seed_);
+    counters c;
+    world w;
+    slot_model slots[slot_count];
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (step_ = 0; step_ < steps; step_++) {
+        auto action = pick(rng, 100);
+        auto& m = slots[pick(rng, slot_count)];
+
+        if (action < 45) {
+            c.resumes += s.run_once();
+        } else if (action < 65) {
+            w.clock.advance(pick(rng, 4));
+            c.timer_fires += w.ts.run_once();
+        } else if (action < 78) {
+            c.activations += w.events[pick(rng, event_count)].activate();
+        } else if (action < 90) {
+            if (m.task) continue;
+            bool full = live_tasks(slots) >= stress_scheduler_config::max_task_count;
+            m.depth = 0;
+            m.finished = false;
+            m.task.emplace(worker(w, m, rng(), 1 + pick(rng, 32)));
+            if (m.task->invalid() != full) fail("registry capacity", &m - slots);
+            if (m.task->invalid()) {
+                m.task.reset();
+                c.spawn_rejects++;
+            } else {
+                if (!s.start(*m.task)) fail("start", &m - slots);
+                c.spawns++;
+            }
+        } else if (action < 95) {
+            if (!m.task || m.finished) continue;
+            m.task.reset();
+            c.cancels++;
+        } else if (action < 99) {
+            for (auto& r: slots) {
+                if (r.task && r.finished) {
+                    r.task.reset();
+                    c.reaps++;
+                }
+            }
+        } else {
+            // Spuriously wakes every suspended task, waiting or not
+            s.schedule_all_suspended();
+        }
+        check(s, slots);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Drive everything to completion; a task still pending afterwards lost a wakeup
+    for (int round = 0; round < 1000 && live_tasks(slots) != 0; round++) {
+        w.clock.advance(1000);
+        while (w.ts.run_once()) {}
+        for (auto& e: w.events) e.activate();
+        while (s.run_once()) {}
+        check(s, slots);
+        for (auto& r: slots) {
+            if (r.task && r.finished) r.task.reset();
+        }
+    }
+    if (live_tasks(slots) != 0) fail("task never finished", 0);
+
+    double secs = std::chrono::duration<double>(elapsed).count();
+    std::printf("{\"seed\":%llu,\"steps\":%zu,\"seconds\":%.3f,\"steps_per_sec\":%.0f,\"resumes_per_sec\":%.0f,"
+        "\"resumes\":%zu,\"spawns\":%zu,\"spawn_rejects\":%zu,\"cancels\":%zu,\"reaps\":%zu,"
+        "\"activations\":%zu,\"timer_fires\":%zu}\n",
+        static_cast<unsigned long long>(seed_), steps, secs, steps / secs, c.resumes / secs,
+        c.resumes, c.spawns, c.spawn_rejects, c.cancels, c.reaps, c.activations, c.timer_fires);
+
+    return EXIT_SUCCESS;
+}
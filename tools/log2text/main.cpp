@@ -0,0 +1,133 @@
+#include <coronimo/log.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Formats a dumped coronimo deferred log as text, one message per line.
+ *
+ * Usage: log2text <dump> [cycles_per_us]
+ *
+ * The dump is what log_ring::dump() writes, as captured from the target.
+ * cycles_per_us overrides the rate stored in the dump header; without either,
+ * timestamps are shown in raw cycles. Format strings travel in the dump, %s
+ * arguments point into the target's memory and are shown as addresses.
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+static uint64_t read_le(uint8_t const* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <dump> [cycles_per_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    std::vector<uint8_t> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    // Header fields are read one by one, the dump may come from a target with a different ABI
+    constexpr size_t header_size = 20;
+    if (data.size() < header_size || read_le(&data[0], 4) != cc::log_dump_header::magic_value) {
+        std::fprintf(stderr, "%s: not a log dump\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    auto version = read_le(&data[4], 2);
+    size_t pointer_size = data[6];
+    double cycles_per_us = static_cast<double>(read_le(&data[8], 4));
+    size_t count = read_le(&data[12], 4);
+    size_t lost = read_le(&data[16], 4);
+
+    if (version != cc::log_dump_header::version_value || pointer_size == 0 || pointer_size > 8) {
+        std::fprintf(stderr, "%s: unsupported dump version %u\n", argv[1], static_cast<unsigned>(version));
+        return EXIT_FAILURE;
+    }
+    bool cycles = false;
+    if (argc > 2) {
+        cycles_per_us = std::strtod(argv[2], nullptr);
+    }
+    if (cycles_per_us <= 0) {
+        cycles = true;
+        cycles_per_us = 1;
+    }
+    if (lost != 0) {
+        std::printf("-- %zu older messages lost --\n", lost);
+    }
+
+    std::map<uint64_t, std::string> formats;
+    size_t pos = header_size;
+    size_t entries = 0;
+    auto available = [&](size_t n) { return data.size() - pos >= n; };
+
+    // Timestamps are 32-bit and wrap, unwrap them assuming entries are less than one period apart
+    uint64_t time = 0;
+    uint32_t last = 0;
+
+    while (entries < count && available(1)) {
+        uint8_t tag = data[pos++];
+
+        if (tag == cc::log_dump_header::string_tag) {
+            if (!available(pointer_size + 2)) break;
+            uint64_t address = read_le(&data[pos], pointer_size);
+            size_t length = read_le(&data[pos + pointer_size], 2);
+            pos += pointer_size + 2;
+            if (!available(length)) break;
+            formats[address].assign(reinterpret_cast<char const*>(&data[pos]), length);
+            pos += length;
+        } else if (tag == cc::log_dump_header::entry_tag) {
+            if (!available(5 + pointer_size)) break;
+            auto stamp = static_cast<uint32_t>(read_le(&data[pos], 4));
+            size_t arg_count = data[pos + 4];
+            uint64_t format = read_le(&data[pos + 5], pointer_size);
+            pos += 5 + pointer_size;
+            if (!available(arg_count * pointer_size)) break;
+
+            std::vector<uint64_t> args(arg_count);
+            for (size_t i = 0; i < arg_count; i++) {
+                args[i] = read_le(&data[pos + i * pointer_size], pointer_size);
+            }
+            pos += arg_count * pointer_size;
+
+            time = entries == 0 ? 0 : time + static_cast<uint32_t>(stamp - last);
+            last = stamp;
+            entries++;
+
+            auto it = formats.find(format);
+            if (it == formats.end()) {
+                std::printf("[%12.3f] <unknown format 0x%llx>\n", static_cast<double>(time) / cycles_per_us,
+                    static_cast<unsigned long long>(format));
+                continue;
+            }
+
+            char line[512];
+            cc::format_log_message(line, sizeof(line), it->second.c_str(), args.data(), args.size(), pointer_size, false);
+            std::printf("[%12.3f] %s\n", static_cast<double>(time) / cycles_per_us, line);
+        } else {
+            std::fprintf(stderr, "%s: corrupt chunk at offset %zu\n", argv[1], pos - 1);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (entries < count) {
+        std::fprintf(stderr, "%s: truncated, expected %zu messages\n", argv[1], count);
+    }
+    if (cycles) {
+        std::fprintf(stderr, "%s: cycle rate unknown, timestamps are in cycles\n", argv[1]);
+    }
+
+    return EXIT_SUCCESS;
+}
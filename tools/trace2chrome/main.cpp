@@ -0,0 +1,163 @@
+#include <coronimo/trace.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+/*
+ * Converts a dumped coronimo trace ring into Chrome-trace JSON, which can be
+ * opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Usage: trace2chrome <dump> [cycles_per_us] > trace.json
+ *
+ * The dump is what trace_ring::dump() writes, as captured from the target.
+ * cycles_per_us overrides the rate stored in the dump header; without either,
+ * timestamps are shown in raw cycles.
+ *
+ * Mapping:
+ * - every task gets its own thread, task_resume/task_suspend become run slices
+ * - async_func frames and timers become async spans, keyed by their address
+ * - event activations become instant events on the thread of the activating task
+ * - records made outside any task land on thread 0
+ */
+
+using namespace adva;
+namespace cc = coronimo;
+
+static uint64_t read_le(uint8_t const* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+}
+
+static char const* state_name(unsigned state) {
+    static char const* names[] = { "INACTIVE", "SUSPENDED", "SCHEDULED", "ACTIVE", "DONE", "ZOMBIE" };
+    return state < std::size(names) ? names[state] : "?";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <dump> [cycles_per_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    std::vector<uint8_t> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    // Header fields are read one by one, the dump may come from a target with a different ABI
+    constexpr size_t header_size = 20;
+    if (data.size() < header_size || read_le(&data[0], 4) != cc::trace_dump_header::magic_value) {
+        std::fprintf(stderr, "%s: not a trace dump\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    auto version = read_le(&data[4], 2);
+    size_t pointer_size = data[6];
+    size_t record_size = data[7];
+    double cycles_per_us = static_cast<double>(read_le(&data[8], 4));
+    size_t count = read_le(&data[12], 4);
+    size_t lost = read_le(&data[16], 4);
+
+    if (version != cc::trace_dump_header::version_value || record_size < 8 + 2 * pointer_size) {
+        std::fprintf(stderr, "%s: unsupported dump version %u\n", argv[1], static_cast<unsigned>(version));
+        return EXIT_FAILURE;
+    }
+    if (argc > 2) {
+        cycles_per_us = std::strtod(argv[2], nullptr);
+    }
+    if (cycles_per_us <= 0) {
+        std::fprintf(stderr, "%s: cycle rate unknown, timestamps are in cycles\n", argv[1]);
+        cycles_per_us = 1;
+    }
+    if (data.size() < header_size + count * record_size) {
+        std::fprintf(stderr, "%s: truncated, expected %zu records\n", argv[1], count);
+        count = (data.size() - header_size) / record_size;
+    }
+    if (lost != 0) {
+        std::fprintf(stderr, "%s: %zu older records were overwritten\n", argv[1], lost);
+    }
+
+    std::map<uint64_t, unsigned> tids;
+    auto tid_of = [&](uint64_t task) -> unsigned {
+        if (task == 0) return 0;
+        auto [it, inserted] = tids.try_emplace(task, static_cast<unsigned>(tids.size() + 1));
+        return it->second;
+    };
+
+    std::printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    bool first = true;
+    auto emit = [&](char const* fmt, auto... args) {
+        std::printf(first ? "  " : ",\n  ");
+        std::printf(fmt, args...);
+        first = false;
+    };
+
+    // Timestamps are 32-bit and wrap, unwrap them assuming records are less than one period apart
+    uint64_t time = 0;
+    uint32_t last = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t const* r = &data[header_size + i * record_size];
+        auto stamp = static_cast<uint32_t>(read_le(r, 4));
+        auto kind = static_cast<cc::trace_event>(r[4]);
+        unsigned arg = r[5];
+        uint64_t subject = read_le(r + 8, pointer_size);
+        uint64_t task = read_le(r + 8 + pointer_size, pointer_size);
+
+        time = i == 0 ? 0 : time + static_cast<uint32_t>(stamp - last);
+        last = stamp;
+        double ts = static_cast<double>(time) / cycles_per_us;
+        unsigned tid = tid_of(task);
+        auto id = static_cast<unsigned long long>(subject);
+
+        switch (kind) {
+            case cc::trace_event::task_resume:
+                emit("{\"ph\":\"B\",\"name\":\"run\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", tid_of(subject), ts);
+                break;
+            case cc::trace_event::task_suspend:
+                emit("{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"state\":\"%s\"}}",
+                    tid_of(subject), ts, state_name(arg));
+                break;
+            case cc::trace_event::func_push:
+                emit("{\"ph\":\"b\",\"cat\":\"async_func\",\"name\":\"async_func 0x%llx\",\"id\":\"0x%llx\","
+                    "\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"depth\":%u}}", id, id, tid, ts, arg);
+                break;
+            case cc::trace_event::func_pop:
+                emit("{\"ph\":\"e\",\"cat\":\"async_func\",\"name\":\"async_func 0x%llx\",\"id\":\"0x%llx\","
+                    "\"pid\":1,\"tid\":%u,\"ts\":%.3f}", id, id, tid, ts);
+                break;
+            case cc::trace_event::event_activate:
+                emit("{\"ph\":\"i\",\"s\":\"t\",\"name\":\"activate 0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                    id, tid, ts);
+                break;
+            case cc::trace_event::timer_arm:
+                emit("{\"ph\":\"b\",\"cat\":\"timer\",\"name\":\"timer 0x%llx\",\"id\":\"0x%llx\","
+                    "\"pid\":1,\"tid\":%u,\"ts\":%.3f}", id, id, tid, ts);
+                break;
+            case cc::trace_event::timer_fire:
+            case cc::trace_event::timer_abort:
+                emit("{\"ph\":\"e\",\"cat\":\"timer\",\"name\":\"timer 0x%llx\",\"id\":\"0x%llx\","
+                    "\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"result\":\"%s\"}}", id, id, tid, ts,
+                    kind == cc::trace_event::timer_fire ? "fired" : "aborted");
+                break;
+            default:
+                std::fprintf(stderr, "%s: skipping unknown record kind %u\n", argv[1], static_cast<unsigned>(r[4]));
+                break;
+        }
+    }
+
+    emit("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"no task\"}}");
+    for (auto [task, tid]: tids) {
+        emit("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"task 0x%llx\"}}",
+            tid, static_cast<unsigned long long>(task));
+    }
+    std::printf("\n]}\n");
+
+    return EXIT_SUCCESS;
+}